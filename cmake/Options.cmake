@@ -73,6 +73,7 @@ function(set_options)
     endif()
 
     option(OPTION_SURVEY_KEY "Survey-key to use for the opt-in survey (empty if you have none)" "")
+    option(OPTION_SPLIT_MAP_ARRAYS "Use the alternative map layout, which stores the tile types and heights in their own arrays" OFF)
 endfunction()
 
 # Show the values of the generic options.
@@ -86,6 +87,7 @@ function(show_options)
     message(STATUS "Option Use assert - ${OPTION_USE_ASSERTS}")
     message(STATUS "Option Use threads - ${OPTION_USE_THREADS}")
     message(STATUS "Option Use NSIS - ${OPTION_USE_NSIS}")
+    message(STATUS "Option Split map arrays - ${OPTION_SPLIT_MAP_ARRAYS}")
 
     if(OPTION_SURVEY_KEY)
         message(STATUS "Option Survey Key - USED")
@@ -116,4 +118,8 @@ function(add_definitions_based_on_options)
     if(OPTION_SURVEY_KEY)
         add_definitions(-DSURVEY_KEY="${OPTION_SURVEY_KEY}")
     endif()
+
+    if(OPTION_SPLIT_MAP_ARRAYS)
+        add_definitions(-DWITH_SPLIT_MAP_ARRAYS)
+    endif()
 endfunction()
@@ -0,0 +1,252 @@
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file benchmark.cpp Headless benchmark runs of a savegame, see VideoDriver_Null. */
+
+#include "stdafx.h"
+#include "benchmark.h"
+#include "framerate_type.h"
+#include "company_base.h"
+#include "town.h"
+#include "vehicle_base.h"
+#include "map_func.h"
+#include "date_func.h"
+#include "rev.h"
+#include "debug.h"
+#include "core/checksum_func.hpp"
+#include "core/pool_type.hpp"
+#include "core/random_func.hpp"
+#include "sl/saveload.h"
+
+#include <chrono>
+#include <map>
+
+#if defined(_WIN32)
+#include <windows.h>
+#include <psapi.h>
+#elif defined(UNIX)
+#include <sys/resource.h>
+#endif
+
+#include "safeguards.h"
+
+static std::chrono::steady_clock::time_point _benchmark_start; ///< Start of the benchmark run.
+
+/**
+ * Get the peak resident memory of the process.
+ * @return The peak resident memory in bytes, or 0 when it is not known on this platform.
+ */
+static uint64 GetPeakResidentMemory()
+{
+#if defined(_WIN32)
+	PROCESS_MEMORY_COUNTERS pmc;
+	if (GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc))) return pmc.PeakWorkingSetSize;
+	return 0;
+#elif defined(UNIX)
+	struct rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+#if defined(__APPLE__)
+	return usage.ru_maxrss;
+#else
+	return (uint64)usage.ru_maxrss * 1024;
+#endif
+#else
+	return 0;
+#endif
+}
+
+/**
+ * Calculate a checksum of the game state at the end of a benchmark run.
+ * Two runs of the same savegame for the same number of ticks must give the same checksum.
+ * @return The checksum.
+ */
+static uint64 CalculateBenchmarkStateChecksum()
+{
+	SimpleChecksum64 checksum;
+	checksum.Update(((uint64)_random.state[0] << 32) | _random.state[1]);
+	checksum.Update((uint64)_scaled_date_ticks);
+	for (const Vehicle *v : Vehicle::Iterate()) {
+		checksum.Update(((uint64)v->index << 32) | ((uint64)v->type << 24) | v->direction);
+		checksum.Update(((uint64)v->tile << 32) | v->cargo.StoredCount());
+		checksum.Update(((uint64)(uint32)v->x_pos << 32) | (uint32)v->y_pos);
+		checksum.Update(((uint64)(uint32)v->z_pos << 32) | ((uint64)v->cur_speed << 16) | ((uint64)v->subspeed << 8) | v->progress);
+	}
+	for (const Company *c : Company::Iterate()) {
+		checksum.Update((uint64)(int64)c->money);
+		checksum.Update((uint64)(int64)c->current_loan);
+	}
+	for (const Town *t : Town::Iterate()) {
+		checksum.Update(((uint64)t->index << 32) | t->cache.population);
+	}
+	return checksum.state;
+}
+
+/**
+ * Write a string as JSON string literal.
+ * @param f The file to write to.
+ * @param str The string.
+ */
+static void WriteJsonString(FILE *f, const char *str)
+{
+	fputc('"', f);
+	for (const char *p = str; *p != '\0'; p++) {
+		switch (*p) {
+			case '"':  fputs("\\\"", f); break;
+			case '\\': fputs("\\\\", f); break;
+			default:
+				if ((byte)*p < 0x20) {
+					fprintf(f, "\\u%04x", (byte)*p);
+				} else {
+					fputc(*p, f);
+				}
+				break;
+		}
+	}
+	fputc('"', f);
+}
+
+/** Values of a report of an earlier run, which a run is compared against. */
+struct BenchmarkBaseline {
+	uint ticks = 0;                                        ///< Number of ticks of the run.
+	uint64 checksum = 0;                                   ///< State checksum at the end of the run.
+	std::map<std::string, PerformanceBenchmarkElement> elements; ///< Measured elements by key, only the numbers are valid.
+};
+
+/**
+ * Read the values of a report which was written by an earlier benchmark run.
+ * This only understands the layout written by EndBenchmark, it is not a general JSON parser.
+ * @param filename The report.
+ * @param[out] baseline The values.
+ * @return Whether the report could be read.
+ */
+static bool ReadBenchmarkBaseline(const char *filename, BenchmarkBaseline &baseline)
+{
+	FILE *f = fopen(filename, "r");
+	if (f == nullptr) return false;
+
+	char line[512];
+	while (fgets(line, lengthof(line), f) != nullptr) {
+		char key[64];
+		PerformanceBenchmarkElement elem{};
+		uint64 checksum;
+		if (sscanf(line, " \"%63[^\"]\": { \"samples\": %u, \"avg_ms\": %lf, \"p50_ms\": %lf, \"p95_ms\": %lf, \"p99_ms\": %lf, \"max_ms\": %lf }",
+				key, &elem.samples, &elem.avg_ms, &elem.p50_ms, &elem.p95_ms, &elem.p99_ms, &elem.max_ms) == 7) {
+			baseline.elements[key] = elem;
+		} else if (sscanf(line, " \"ticks\": %u", &baseline.ticks) == 1) {
+			/* Read ticks */
+		} else if (sscanf(line, " \"checksum\": \"%" SCNx64 "\"", &checksum) == 1) {
+			baseline.checksum = checksum;
+		}
+	}
+	fclose(f);
+	return !baseline.elements.empty();
+}
+
+/** Start measuring a benchmark run, after the savegame has been loaded. */
+void BeginBenchmark()
+{
+	BeginPerformanceBenchmark();
+	_benchmark_start = std::chrono::steady_clock::now();
+}
+
+/**
+ * Finish a benchmark run: write the report and compare it against the baseline.
+ * @param options The options of the run.
+ * @param ticks The number of ticks which were run.
+ * @return False when the run is slower than allowed by the baseline, or its end state differs.
+ */
+bool EndBenchmark(const BenchmarkOptions &options, uint ticks)
+{
+	const uint64 wall_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - _benchmark_start).count();
+	const std::vector<PerformanceBenchmarkElement> elements = EndPerformanceBenchmark();
+	const uint64 checksum = CalculateBenchmarkStateChecksum();
+
+	BenchmarkBaseline baseline;
+	bool have_baseline = false;
+	if (options.baseline != nullptr) {
+		have_baseline = ReadBenchmarkBaseline(options.baseline, baseline);
+		if (!have_baseline) DEBUG(misc, 0, "Benchmark: could not read baseline report '%s'", options.baseline);
+	}
+
+	/* The percentiles of the elements which are slower than allowed by the baseline. */
+	std::vector<std::string> regressions;
+	if (have_baseline) {
+		for (const PerformanceBenchmarkElement &elem : elements) {
+			auto it = baseline.elements.find(elem.key);
+			if (it == baseline.elements.end()) continue;
+
+			auto check = [&](const char *name, double value, double base) {
+				/* Ignore differences below the timer resolution. */
+				if (value > base * (100 + options.threshold) / 100 && value - base >= 0.01) {
+					char buf[128];
+					seprintf(buf, lastof(buf), "%s %s: %.3f ms -> %.3f ms", elem.key, name, base, value);
+					regressions.push_back(buf);
+				}
+			};
+			check("p50", elem.p50_ms, it->second.p50_ms);
+			check("p99", elem.p99_ms, it->second.p99_ms);
+		}
+	}
+	const bool checksum_match = !have_baseline || baseline.ticks != ticks || baseline.checksum == checksum;
+
+	FILE *f = strcmp(options.report, "-") == 0 ? stdout : fopen(options.report, "w");
+	if (f == nullptr) {
+		DEBUG(misc, 0, "Benchmark: could not write report '%s'", options.report);
+	} else {
+		fprintf(f, "{\n");
+		fprintf(f, "  \"version\": ");
+		WriteJsonString(f, _openttd_revision);
+		fprintf(f, ",\n  \"savegame\": ");
+		WriteJsonString(f, _file_to_saveload.name.c_str());
+		fprintf(f, ",\n  \"map_size\": [%u, %u],\n", MapSizeX(), MapSizeY());
+		fprintf(f, "  \"ticks\": %u,\n", ticks);
+		fprintf(f, "  \"wall_ms\": %.3f,\n", wall_ns / 1000000.0);
+		fprintf(f, "  \"ticks_per_second\": %.3f,\n", wall_ns == 0 ? 0.0 : ticks * 1000000000.0 / wall_ns);
+		fprintf(f, "  \"peak_rss_bytes\": " OTTD_PRINTF64U ",\n", GetPeakResidentMemory());
+		fprintf(f, "  \"checksum\": \"%016" OTTD_PRINTFHEX64_SUFFIX "\",\n", checksum);
+
+		fprintf(f, "  \"elements\": {\n");
+		for (size_t i = 0; i < elements.size(); i++) {
+			const PerformanceBenchmarkElement &elem = elements[i];
+			fprintf(f, "    \"%s\": { \"samples\": %u, \"avg_ms\": %.4f, \"p50_ms\": %.4f, \"p95_ms\": %.4f, \"p99_ms\": %.4f, \"max_ms\": %.4f }%s\n",
+					elem.key, elem.samples, elem.avg_ms, elem.p50_ms, elem.p95_ms, elem.p99_ms, elem.max_ms, i + 1 < elements.size() ? "," : "");
+		}
+		fprintf(f, "  },\n");
+
+		fprintf(f, "  \"pools\": [\n");
+		const PoolVector &pools = *PoolBase::GetPools();
+		for (size_t i = 0; i < pools.size(); i++) {
+			fprintf(f, "    { \"name\": ");
+			WriteJsonString(f, pools[i]->GetName());
+			fprintf(f, ", \"items\": " PRINTF_SIZE ", \"size\": " PRINTF_SIZE " }%s\n", pools[i]->GetItemCount(), pools[i]->GetAllocatedSize(), i + 1 < pools.size() ? "," : "");
+		}
+		fprintf(f, "  ]");
+
+		if (have_baseline) {
+			fprintf(f, ",\n  \"baseline\": {\n    \"file\": ");
+			WriteJsonString(f, options.baseline);
+			fprintf(f, ",\n    \"threshold_percent\": %u,\n", options.threshold);
+			fprintf(f, "    \"checksum_match\": %s,\n", checksum_match ? "true" : "false");
+			fprintf(f, "    \"regressions\": [");
+			for (size_t i = 0; i < regressions.size(); i++) {
+				fprintf(f, "%s\n      ", i == 0 ? "" : ",");
+				WriteJsonString(f, regressions[i].c_str());
+			}
+			fprintf(f, "%s]\n  }", regressions.empty() ? "" : "\n    ");
+		}
+		fprintf(f, "\n}\n");
+
+		if (f != stdout) fclose(f);
+	}
+
+	for (const std::string &regression : regressions) {
+		DEBUG(misc, 0, "Benchmark regression: %s", regression.c_str());
+	}
+	if (!checksum_match) DEBUG(misc, 0, "Benchmark: state checksum %016" OTTD_PRINTFHEX64_SUFFIX " differs from baseline %016" OTTD_PRINTFHEX64_SUFFIX, checksum, baseline.checksum);
+
+	return regressions.empty() && checksum_match;
+}
@@ -0,0 +1,23 @@
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file benchmark.h Headless benchmark runs of a savegame, see VideoDriver_Null. */
+
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+/** Options of a benchmark run. */
+struct BenchmarkOptions {
+	const char *report = nullptr;   ///< File to write the JSON report to, "-" for the console.
+	const char *baseline = nullptr; ///< Report of an earlier run to compare against, if any.
+	uint threshold = 10;            ///< Allowed slowdown relative to the baseline, in percent.
+};
+
+void BeginBenchmark();
+bool EndBenchmark(const BenchmarkOptions &options, uint ticks);
+
+#endif /* BENCHMARK_H */
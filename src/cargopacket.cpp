@@ -19,6 +19,7 @@
 #include "string_func.h"
 #include "strings_func.h"
 #include "3rdparty/cpp-btree/btree_map.h"
+#include <chrono>
 
 #include <vector>
 
@@ -441,6 +442,7 @@ void VehicleCargoList::Append(CargoPacket *cp, MoveToAction action)
 template<class Taction>
 void VehicleCargoList::ShiftCargo(Taction action)
 {
+	this->MaterialiseAge();
 	Iterator it(this->packets.begin());
 	while (it != this->packets.end() && action.MaxMove() > 0) {
 		CargoPacket *cp = *it;
@@ -465,6 +467,7 @@ void VehicleCargoList::ShiftCargo(Taction action)
 template<class Taction, class Tfilter>
 void VehicleCargoList::ShiftCargoWithFrontInsert(Taction action, Tfilter filter)
 {
+	this->MaterialiseAge();
 	std::vector<CargoPacket *> packets_to_front_insert;
 
 	Iterator it(this->packets.begin());
@@ -498,6 +501,7 @@ template<class Taction>
 void VehicleCargoList::PopCargo(Taction action)
 {
 	if (this->packets.empty()) return;
+	this->MaterialiseAge();
 	for (auto it = this->packets.end(); it != this->packets.begin();) {
 		if (action.MaxMove() <= 0) break;
 		--it;
@@ -518,6 +522,7 @@ void VehicleCargoList::PopCargo(Taction action)
  */
 void VehicleCargoList::RemoveFromCache(const CargoPacket *cp, uint count)
 {
+	dbg_assert(this->pending_age == 0);
 	this->feeder_share -= cp->FeederShare(count);
 	this->Parent::RemoveFromCache(cp, count);
 }
@@ -529,6 +534,8 @@ void VehicleCargoList::RemoveFromCache(const CargoPacket *cp, uint count)
  */
 void VehicleCargoList::AddToCache(const CargoPacket *cp)
 {
+	this->MaterialiseAge();
+	this->age_headroom = std::min<uint16>(this->age_headroom, UINT16_MAX - cp->days_in_transit);
 	this->feeder_share += cp->feeder_share;
 	this->Parent::AddToCache(cp);
 }
@@ -563,16 +570,47 @@ void VehicleCargoList::AddToMeta(const CargoPacket *cp, MoveToAction action)
 
 /**
  * Ages the all cargo in this list.
+ * As long as no packet can reach the maximum transit time, this only counts the aging period in
+ * #pending_age and updates the cache, the packets themselves are updated by #MaterialiseAge when needed.
  */
 void VehicleCargoList::AgeCargo()
 {
+	if (this->count == 0) return;
+
+	if (likely(this->pending_age < this->age_headroom)) {
+		this->pending_age++;
+		this->cargo_days_in_transit += this->count;
+		return;
+	}
+
+	uint16 headroom = UINT16_MAX;
 	for (const auto &cp : this->packets) {
+		uint days = std::min<uint>(cp->days_in_transit + this->pending_age, UINT16_MAX);
+
 		/* If we're at the maximum, then we can't increase no more. */
-		if (cp->days_in_transit == UINT16_MAX) continue;
+		if (days != UINT16_MAX) {
+			days++;
+			this->cargo_days_in_transit += cp->count;
+		}
+		cp->days_in_transit = days;
+		headroom = std::min<uint16>(headroom, UINT16_MAX - days);
+	}
+	this->pending_age = 0;
+	this->age_headroom = headroom;
+}
 
-		cp->days_in_transit++;
-		this->cargo_days_in_transit += cp->count;
+/**
+ * Apply the aging periods deferred by #AgeCargo to all packets in this list.
+ */
+void VehicleCargoList::ApplyPendingAge()
+{
+	uint16 headroom = UINT16_MAX;
+	for (const auto &cp : this->packets) {
+		cp->days_in_transit = std::min<uint>(cp->days_in_transit + this->pending_age, UINT16_MAX);
+		headroom = std::min<uint16>(headroom, UINT16_MAX - cp->days_in_transit);
 	}
+	this->pending_age = 0;
+	this->age_headroom = headroom;
 }
 
 /**
@@ -630,6 +668,7 @@ void VehicleCargoList::SetTransferLoadPlace(TileIndex xy)
  */
 bool VehicleCargoList::Stage(bool accepted, StationID current_station, StationIDStack next_station, uint8 order_flags, const GoodsEntry *ge, CargoPayment *payment)
 {
+	this->MaterialiseAge();
 	this->AssertCountConsistency();
 	dbg_assert(this->action_counts[MTA_LOAD] == 0);
 	this->action_counts[MTA_TRANSFER] = this->action_counts[MTA_DELIVER] = this->action_counts[MTA_KEEP] = 0;
@@ -725,6 +764,8 @@ bool VehicleCargoList::Stage(bool accepted, StationID current_station, StationID
 /** Invalidates the cached data and rebuild it. */
 void VehicleCargoList::InvalidateCache()
 {
+	this->MaterialiseAge();
+	this->age_headroom = UINT16_MAX;
 	this->feeder_share = 0;
 	this->Parent::InvalidateCache();
 }
@@ -1153,6 +1194,76 @@ uint StationCargoList::RerouteFromSource(uint max_move, StationCargoList *dest,
 	return this->ShiftCargoFromSource(StationCargoReroute(this, dest, max_move, avoid, avoid2, ge), source, avoid, false);
 }
 
+/**
+ * Benchmark loading and unloading on a station with many waiting cargo packets.
+ * The packets are spread over a number of next hops and do not merge. Vehicles of a fixed capacity
+ * first reserve all cargo and return it to a second station list, then load all cargo and remove it.
+ * @param b Buffer to write the result to.
+ * @param last Last valid byte of the buffer.
+ * @param packet_count Number of waiting packets.
+ * @return Updated buffer position.
+ */
+char *BenchmarkCargoPacketLoadUnload(char *b, const char *last, uint packet_count)
+{
+	static const uint NEXT_HOPS = 64;
+	static const uint VEHICLE_CAPACITY = 1000;
+
+	packet_count = std::max<uint>(packet_count, 1);
+	if (!CargoPacket::CanAllocateItem(packet_count + packet_count / 8 + NEXT_HOPS)) {
+		b += seprintf(b, last, "Not enough free cargo packets for %u packets\n", packet_count);
+		return b;
+	}
+
+	auto now = []() { return std::chrono::steady_clock::now(); };
+	auto elapsed_us = [](std::chrono::steady_clock::time_point start) -> uint64 {
+		return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+	};
+	auto print_phase = [&](const char *name, uint64 us, uint moved) {
+		b += seprintf(b, last, "  %-16s " OTTD_PRINTF64U " us, %.2f M packets/s, %u cargo moved\n",
+				name, us, us > 0 ? (double)packet_count / us : 0.0, moved);
+	};
+
+	b += seprintf(b, last, "Packets: %u, next hops: %u, vehicle capacity: %u\n", packet_count, NEXT_HOPS, VEHICLE_CAPACITY);
+
+	StationCargoList waiting;
+	StationCargoList returned;
+	VehicleCargoList vehicle;
+	uint total = 0;
+
+	auto start = now();
+	for (uint i = 0; i < packet_count; i++) {
+		CargoPacket *cp = new CargoPacket(i % 256, i, 1 + i % 31, SourceType::Industry, i % 1024);
+		total += cp->Count();
+		waiting.Append(cp, i % NEXT_HOPS);
+	}
+	print_phase("append", elapsed_us(start), total);
+
+	uint moved = 0;
+	start = now();
+	for (StationID hop = 0; hop < NEXT_HOPS; hop++) {
+		uint reserved;
+		while ((reserved = waiting.Reserve(VEHICLE_CAPACITY, &vehicle, INVALID_TILE, StationIDStack(hop))) > 0) {
+			moved += vehicle.Return(reserved, &returned, hop);
+		}
+	}
+	print_phase("reserve/return", elapsed_us(start), moved);
+
+	moved = 0;
+	start = now();
+	for (StationID hop = 0; hop < NEXT_HOPS; hop++) {
+		uint loaded;
+		while ((loaded = returned.Load(VEHICLE_CAPACITY, &vehicle, INVALID_TILE, StationIDStack(hop))) > 0) {
+			moved += vehicle.Truncate();
+		}
+	}
+	print_phase("load/remove", elapsed_us(start), moved);
+
+	if (moved != total || waiting.TotalCount() != 0 || returned.TotalCount() != 0 || vehicle.TotalCount() != 0) {
+		b += seprintf(b, last, "  Cargo mismatch: %u of %u moved\n", moved, total);
+	}
+	return b;
+}
+
 /*
  * We have to instantiate everything we want to be usable.
  */
@@ -242,8 +242,8 @@ public:
 	};
 
 protected:
-	uint count;                   ///< Cache for the number of cargo entities.
-	uint64 cargo_days_in_transit; ///< Cache for the sum of number of days in transit of each entity; comparable to man-hours.
+	uint count = 0;                   ///< Cache for the number of cargo entities.
+	uint64 cargo_days_in_transit = 0; ///< Cache for the sum of number of days in transit of each entity; comparable to man-hours.
 
 	Tcont packets;              ///< The cargo packets in this list.
 
@@ -306,8 +306,10 @@ protected:
 	/** The (direct) parent of this class. */
 	typedef CargoList<VehicleCargoList, CargoPacketList> Parent;
 
-	Money feeder_share;                     ///< Cache for the feeder share.
-	uint action_counts[NUM_MOVE_TO_ACTION]; ///< Counts of cargo to be transferred, delivered, kept and loaded.
+	Money feeder_share = 0;                      ///< Cache for the feeder share.
+	uint action_counts[NUM_MOVE_TO_ACTION] = {}; ///< Counts of cargo to be transferred, delivered, kept and loaded.
+	uint16 pending_age = 0;                      ///< NOSAVE: Number of cargo aging periods not yet applied to the packets, see #AgeCargo.
+	uint16 age_headroom = 0;                     ///< NOSAVE: Lower bound of the number of periods any packet can still age before reaching the maximum.
 
 	template<class Taction>
 	void ShiftCargo(Taction action);
@@ -358,6 +360,8 @@ protected:
 	static MoveToAction ChooseAction(const CargoPacket *cp, StationID cargo_next,
 			StationID current_station, bool accepted, StationIDStack next_station);
 
+	void ApplyPendingAge();
+
 public:
 	/** The station cargo list needs to control the unloading. */
 	friend class StationCargoList;
@@ -444,6 +448,15 @@ public:
 
 	void AgeCargo();
 
+	/**
+	 * Apply any deferred aging to the packets in this list.
+	 * This must be done before packets are split, moved out of the list or their transit time is otherwise used.
+	 */
+	inline void MaterialiseAge()
+	{
+		if (this->pending_age != 0) this->ApplyPendingAge();
+	}
+
 	void InvalidateCache();
 
 	void SetTransferLoadPlace(TileIndex xy);
@@ -502,7 +515,7 @@ protected:
 	/** The (direct) parent of this class. */
 	typedef CargoList<StationCargoList, StationCargoPacketMap> Parent;
 
-	uint reserved_count; ///< Amount of cargo being reserved for loading.
+	uint reserved_count = 0; ///< Amount of cargo being reserved for loading.
 
 public:
 	/** The super class ought to know what it's doing. */
@@ -61,6 +61,7 @@
 #include "event_logs.h"
 #include "tile_cmd.h"
 #include "object_base.h"
+#include "pathfinder/yapf/yapf_stats.h"
 #include <time.h>
 
 #include <set>
@@ -2613,6 +2614,142 @@ DEF_CONSOLE_CMD(ConDumpCpdpStats)
 	return true;
 }
 
+DEF_CONSOLE_CMD(ConDumpYapfCacheStats)
+{
+	if (argc == 0) {
+		IConsoleHelp("Dump YAPF rail segment cost cache and route cache stats.");
+		return true;
+	}
+
+	extern void DumpYapfRailSegmentCacheStats(char *b, const char *last);
+	char buffer[4096];
+	DumpYapfRailSegmentCacheStats(buffer, lastof(buffer));
+	PrintLineByLine(buffer);
+	return true;
+}
+
+DEF_CONSOLE_CMD(ConYapfStats)
+{
+	if (argc == 0) {
+		IConsoleHelp("Show YAPF search statistics per vehicle type. Usage: 'yapf_stats [dump | csv | reset]'");
+		IConsoleHelp("  'dump' (the default) shows node counts, max_search_nodes cutoffs, search times and their histograms.");
+		IConsoleHelp("  'csv' prints the same counters and histograms as CSV, 'reset' clears them.");
+		return true;
+	}
+
+	if (argc == 1 || strcmp(argv[1], "dump") == 0) {
+		char buffer[32768];
+		DumpYapfSearchStats(buffer, lastof(buffer));
+		PrintLineByLine(buffer);
+		return true;
+	}
+
+	if (strcmp(argv[1], "csv") == 0) {
+		char buffer[32768];
+		DumpYapfSearchStatsCsv(buffer, lastof(buffer));
+		PrintLineByLine(buffer);
+		return true;
+	}
+
+	if (strcmp(argv[1], "reset") == 0) {
+		ResetYapfSearchStats();
+		IConsolePrint(CC_DEFAULT, "YAPF search statistics reset");
+		return true;
+	}
+
+	return false;
+}
+
+DEF_CONSOLE_CMD(ConBenchmarkMCFDijkstra)
+{
+	if (argc == 0) {
+		IConsoleHelp("Benchmark the link graph MCF Dijkstra priority queues on synthetic graphs. Usage: 'benchmark_mcf_dijkstra [<nodes> ...]'");
+		IConsoleHelp("  Default node counts: 1000, 10000, 50000.");
+		return true;
+	}
+
+	extern char *BenchmarkMCFDijkstraQueues(char *b, const char *last, uint node_count);
+
+	std::vector<uint> node_counts;
+	for (int i = 1; i < argc; i++) {
+		uint32 value;
+		if (!GetArgumentInteger(&value, argv[i])) return false;
+		node_counts.push_back(value);
+	}
+	if (node_counts.empty()) node_counts = { 1000, 10000, 50000 };
+
+	for (uint node_count : node_counts) {
+		char buffer[1024];
+		BenchmarkMCFDijkstraQueues(buffer, lastof(buffer), node_count);
+		PrintLineByLine(buffer);
+	}
+	return true;
+}
+
+DEF_CONSOLE_CMD(ConBenchmarkCargoPackets)
+{
+	if (argc == 0) {
+		IConsoleHelp("Benchmark loading and unloading on a station with many waiting cargo packets. Usage: 'benchmark_cargo_packets [<packets> ...]'");
+		IConsoleHelp("  Default packet count: 100000.");
+		return true;
+	}
+
+	extern char *BenchmarkCargoPacketLoadUnload(char *b, const char *last, uint packet_count);
+
+	std::vector<uint> packet_counts;
+	for (int i = 1; i < argc; i++) {
+		uint32 value;
+		if (!GetArgumentInteger(&value, argv[i])) return false;
+		packet_counts.push_back(value);
+	}
+	if (packet_counts.empty()) packet_counts = { 100000 };
+
+	for (uint packet_count : packet_counts) {
+		char buffer[1024];
+		BenchmarkCargoPacketLoadUnload(buffer, lastof(buffer), packet_count);
+		PrintLineByLine(buffer);
+	}
+	return true;
+}
+
+DEF_CONSOLE_CMD(ConBenchmarkVehicleTileHash)
+{
+	if (argc == 0) {
+		IConsoleHelp("Dump vehicle tile hash statistics and benchmark vehicle position queries on the current game. Usage: 'benchmark_vehicle_tile_hash [<iterations>]'");
+		IConsoleHelp("  Default iterations: 10.");
+		return true;
+	}
+
+	extern char *BenchmarkVehicleTileHash(char *b, const char *last, uint iterations);
+
+	uint32 iterations = 10;
+	if (argc > 1 && !GetArgumentInteger(&iterations, argv[1])) return false;
+
+	char buffer[2048];
+	BenchmarkVehicleTileHash(buffer, lastof(buffer), iterations);
+	PrintLineByLine(buffer);
+	return true;
+}
+
+DEF_CONSOLE_CMD(ConBenchmarkYapf)
+{
+	if (argc == 0) {
+		IConsoleHelp("Benchmark YAPF searches on the vehicles of the current game, with and without reusing the node list storage. Usage: 'benchmark_yapf [<iterations>]'");
+		IConsoleHelp("  Also compares the binary and 4-ary heap on a synthetic workload. Default iterations: 10.");
+		return true;
+	}
+
+	extern char *BenchmarkYapfSearches(char *b, const char *last, uint iterations);
+
+	uint32 iterations = 10;
+	if (argc > 1 && !GetArgumentInteger(&iterations, argv[1])) return false;
+
+	char buffer[1024];
+	BenchmarkYapfSearches(buffer, lastof(buffer), iterations);
+	PrintLineByLine(buffer);
+	return true;
+}
+
 DEF_CONSOLE_CMD(ConVehicleStats)
 {
 	if (argc == 0) {
@@ -3613,6 +3750,40 @@ DEF_CONSOLE_CMD(ConFramerateWindow)
 	return true;
 }
 
+DEF_CONSOLE_CMD(ConTileLoopProfile)
+{
+	if (argc == 0) {
+		IConsoleHelp("Profile the tile loop by tile type and NewGRF. Usage: 'tile_loop_profile [on [<window ticks>] | off | dump]'");
+		IConsoleHelp("  'on' starts timing tile loop procs, counters are collected over windows of <window ticks> ticks (default: 2048).");
+		IConsoleHelp("  'dump' (the default) shows the counters of the last complete window.");
+		IConsoleHelp("  While enabled, the time spent per tile type is also shown in the frame rate window.");
+		return true;
+	}
+
+	if (argc == 1 || strcmp(argv[1], "dump") == 0) {
+		char buffer[32768];
+		DumpTileLoopProfile(buffer, lastof(buffer));
+		PrintLineByLine(buffer);
+		return true;
+	}
+
+	if (strcmp(argv[1], "on") == 0) {
+		uint32 window_ticks = 2048;
+		if (argc > 2 && (!GetArgumentInteger(&window_ticks, argv[2]) || window_ticks == 0)) return false;
+		SetTileLoopProfiling(true, window_ticks);
+		IConsolePrintF(CC_DEFAULT, "Tile loop profiling enabled, window: %u ticks", window_ticks);
+		return true;
+	}
+
+	if (strcmp(argv[1], "off") == 0) {
+		SetTileLoopProfiling(false, 0);
+		IConsolePrint(CC_DEFAULT, "Tile loop profiling disabled");
+		return true;
+	}
+
+	return false;
+}
+
 DEF_CONSOLE_CMD(ConFindNonRealisticBrakingSignal)
 {
 	if (argc == 0) {
@@ -3824,6 +3995,7 @@ void IConsoleStdLibRegister()
 #endif
 	IConsole::CmdRegister("fps",                     ConFramerate);
 	IConsole::CmdRegister("fps_wnd",                 ConFramerateWindow);
+	IConsole::CmdRegister("tile_loop_profile",       ConTileLoopProfile);
 
 	IConsole::CmdRegister("find_non_realistic_braking_signal", ConFindNonRealisticBrakingSignal);
 
@@ -3833,6 +4005,12 @@ void IConsoleStdLibRegister()
 	IConsole::CmdRegister("dump_desync_msgs",        ConDumpDesyncMsgLog, nullptr, true);
 	IConsole::CmdRegister("dump_inflation",          ConDumpInflation,    nullptr, true);
 	IConsole::CmdRegister("dump_cpdp_stats",         ConDumpCpdpStats,    nullptr, true);
+	IConsole::CmdRegister("dump_yapf_cache_stats",   ConDumpYapfCacheStats, nullptr, true);
+	IConsole::CmdRegister("yapf_stats",              ConYapfStats);
+	IConsole::CmdRegister("benchmark_mcf_dijkstra",  ConBenchmarkMCFDijkstra, nullptr, true);
+	IConsole::CmdRegister("benchmark_cargo_packets", ConBenchmarkCargoPackets, ConHookNoNetwork, true);
+	IConsole::CmdRegister("benchmark_vehicle_tile_hash", ConBenchmarkVehicleTileHash, nullptr, true);
+	IConsole::CmdRegister("benchmark_yapf",          ConBenchmarkYapf, nullptr, true);
 	IConsole::CmdRegister("dump_veh_stats",          ConVehicleStats,     nullptr, true);
 	IConsole::CmdRegister("dump_map_stats",          ConMapStats,         nullptr, true);
 	IConsole::CmdRegister("dump_st_flow_stats",      ConStFlowStats,      nullptr, true);
@@ -31,11 +31,35 @@ struct SimpleChecksum64 {
 	}
 };
 
+static_assert(sizeof(SimpleChecksum64) == sizeof(uint64)); // _subsystem_state_checksums is saved as an array of uint64
+
+/**
+ * Parts of the game state which also have their own checksum, so that a desync report can tell which of them diverged.
+ * The checksums are saved, so adding a subsystem needs a new version of XSLFI_STATE_CHECKSUM.
+ */
+enum StateChecksumSubsystem : uint8 {
+	SCS_TRAINS,         ///< Train movement and pathfinding
+	SCS_ROAD_VEHICLES,  ///< Road vehicle movement and pathfinding
+	SCS_SHIPS,          ///< Ship movement and pathfinding
+	SCS_AIRCRAFT,       ///< Aircraft movement
+	SCS_OTHER_VEHICLES, ///< Effect and disaster vehicle movement
+	SCS_COMPANIES,      ///< Company money and infrastructure totals
+	SCS_STATIONS,       ///< Station cargo ratings and waiting cargo
+	SCS_END,
+};
+
+extern bool _networking;
 extern SimpleChecksum64 _state_checksum;
+extern SimpleChecksum64 _subsystem_state_checksums[SCS_END];
+
+const char *GetStateChecksumSubsystemName(StateChecksumSubsystem subsystem);
 
-inline void UpdateStateChecksum(uint64 input)
+inline void UpdateStateChecksum(uint64 input, StateChecksumSubsystem subsystem)
 {
-	if (_networking) _state_checksum.Update(input);
+	if (_networking) {
+		_state_checksum.Update(input);
+		_subsystem_state_checksums[subsystem].Update(input);
+	}
 }
 
 #ifdef RANDOM_DEBUG
@@ -41,7 +41,7 @@ DEFINE_POOL_METHOD(inline)::Pool(const char *name) :
 		cleaning(false),
 		data(nullptr),
 		free_bitmap(nullptr),
-		alloc_cache(nullptr)
+		slabs(nullptr)
 { }
 
 /**
@@ -60,6 +60,11 @@ DEFINE_POOL_METHOD(inline void)::ResizeFor(size_t index)
 	this->data = ReallocT(this->data, new_size);
 	MemSetT(this->data + this->size, 0, new_size - this->size);
 
+	if (Tcache) {
+		this->slabs = ReallocT(this->slabs, CeilDivT<size_t>(new_size, SLAB_ITEMS));
+		MemSetT(this->slabs + CeilDivT<size_t>(this->size, SLAB_ITEMS), 0, CeilDivT<size_t>(new_size, SLAB_ITEMS) - CeilDivT<size_t>(this->size, SLAB_ITEMS));
+	}
+
 	this->free_bitmap = ReallocT(this->free_bitmap, CeilDivT<size_t>(new_size, 64));
 	MemSetT(this->free_bitmap + CeilDivT<size_t>(this->size, 64), 0, CeilDivT<size_t>(new_size, 64) - CeilDivT<size_t>(this->size, 64));
 	if (new_size % 64 != 0) {
@@ -115,10 +120,11 @@ DEFINE_POOL_METHOD(inline void *)::AllocateItem(size_t size, size_t index)
 	this->items++;
 
 	Titem *item;
-	if (Tcache && this->alloc_cache != nullptr) {
+	if (Tcache) {
 		dbg_assert(sizeof(Titem) == size);
-		item = (Titem *)this->alloc_cache;
-		this->alloc_cache = this->alloc_cache->next;
+		byte *&slab = this->slabs[index / SLAB_ITEMS];
+		if (slab == nullptr) slab = MallocT<byte>(SLAB_ITEMS * sizeof(Titem));
+		item = (Titem *)(slab + (index % SLAB_ITEMS) * sizeof(Titem));
 		if (Tzero) {
 			/* Explicitly casting to (void *) prevents a clang warning -
 			 * we are actually memsetting a (not-yet-constructed) object */
@@ -191,13 +197,8 @@ DEFINE_POOL_METHOD(void)::FreeItem(size_t index)
 {
 	dbg_assert(index < this->size);
 	dbg_assert(this->data[index] != nullptr);
-	if (Tcache) {
-		AllocCache *ac = (AllocCache *)this->data[index];
-		ac->next = this->alloc_cache;
-		this->alloc_cache = ac;
-	} else {
-		free(this->data[index]);
-	}
+	/* With caching the memory stays in the slab, ready for the next item with this index. */
+	if (!Tcache) free(this->data[index]);
 	this->data[index] = nullptr;
 	ClrBit(this->free_bitmap[index / 64], index % 64);
 	this->first_free = std::min(this->first_free, index);
@@ -214,20 +215,19 @@ DEFINE_POOL_METHOD(void)::CleanPool()
 		delete this->Get(i); // 'delete nullptr;' is very valid
 	}
 	dbg_assert(this->items == 0);
+	if (Tcache) {
+		for (size_t i = 0; i < CeilDivT<size_t>(this->size, SLAB_ITEMS); i++) {
+			free(this->slabs[i]);
+		}
+		free(this->slabs);
+		this->slabs = nullptr;
+	}
 	free(this->data);
 	free(this->free_bitmap);
 	this->first_unused = this->first_free = this->size = 0;
 	this->data = nullptr;
 	this->free_bitmap = nullptr;
 	this->cleaning = false;
-
-	if (Tcache) {
-		while (this->alloc_cache != nullptr) {
-			AllocCache *ac = this->alloc_cache;
-			this->alloc_cache = ac->next;
-			free(ac);
-		}
-	}
 }
 
 #undef DEFINE_POOL_METHOD
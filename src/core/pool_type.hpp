@@ -58,6 +58,24 @@ struct PoolBase {
 	 */
 	virtual void CleanPool() = 0;
 
+	/**
+	 * Get the name of the pool.
+	 * @return The name.
+	 */
+	virtual const char *GetName() const = 0;
+
+	/**
+	 * Get the number of items in the pool.
+	 * @return The number of used indexes.
+	 */
+	virtual size_t GetItemCount() const = 0;
+
+	/**
+	 * Get the allocated size of the pool.
+	 * @return The number of allocated indexes.
+	 */
+	virtual size_t GetAllocatedSize() const = 0;
+
 private:
 	/**
 	 * Dummy private copy constructor to prevent compilers from
@@ -73,7 +91,7 @@ private:
  * @tparam Tgrowth_step Size of growths; if the pool is full increase the size by this amount
  * @tparam Tmax_size    Maximum size of the pool
  * @tparam Tpool_type   Type of this pool
- * @tparam Tcache       Whether to perform 'alloc' caching, i.e. don't actually free/malloc just reuse the memory
+ * @tparam Tcache       Whether to perform 'alloc' caching, i.e. allocate items in slabs of contiguous memory indexed by item index, and don't actually free/malloc just reuse the memory
  * @tparam Tzero        Whether to zero the memory
  * @warning when Tcache is enabled *all* instances of this pool's item must be of the same size.
  */
@@ -101,6 +119,10 @@ struct Pool : PoolBase {
 	Pool(const char *name);
 	virtual void CleanPool();
 
+	const char *GetName() const override { return this->name; }
+	size_t GetItemCount() const override { return this->items; }
+	size_t GetAllocatedSize() const override { return this->size; }
+
 	/**
 	 * Returns Titem with given index
 	 * @param index of item to get
@@ -397,17 +419,16 @@ struct Pool : PoolBase {
 private:
 	static const size_t NO_FREE_ITEM = MAX_UVALUE(size_t); ///< Constant to indicate we can't allocate any more items
 
+	/** Number of items per slab when caching allocations. */
+	static constexpr size_t SLAB_ITEMS = std::max<size_t>(64, Tgrowth_step);
+
 	/**
-	 * Helper struct to cache 'freed' PoolItems so we
-	 * do not need to allocate them again.
+	 * Slabs of item memory when caching allocations, one per SLAB_ITEMS indexes.
+	 * The memory of an item is at a fixed place in the slab of its index, so items
+	 * with neighbouring indexes are contiguous in memory and freed items do not need
+	 * to be allocated again.
 	 */
-	struct AllocCache {
-		/** The next in our 'cache' */
-		AllocCache *next;
-	};
-
-	/** Cache of freed pointers */
-	AllocCache *alloc_cache;
+	byte **slabs;
 
 	void *AllocateItem(size_t size, size_t index);
 	void ResizeFor(size_t index);
@@ -24,6 +24,7 @@
 #include "screenshot.h"
 #include "gfx_func.h"
 #include "network/network.h"
+#include "core/checksum_func.hpp"
 #include "network/network_survey.h"
 #include "language.h"
 #include "fontcache.h"
@@ -642,6 +643,13 @@ char *CrashLog::FillDesyncCrashLog(char *buffer, const char *last, const DesyncE
 	if (_network_server && (info.desync_frame_seed || info.desync_frame_state_checksum)) {
 		buffer += seprintf(buffer, last, "Desync frame: %08X (seed), %08X (state checksum)\n", info.desync_frame_seed, info.desync_frame_state_checksum);
 	}
+	if (_network_server && info.desync_frame_state_subsystems != 0) {
+		buffer += seprintf(buffer, last, "Desync state checksum subsystems:");
+		for (uint i = 0; i < SCS_END; i++) {
+			if (HasBit(info.desync_frame_state_subsystems, i)) buffer += seprintf(buffer, last, " %s", GetStateChecksumSubsystemName((StateChecksumSubsystem)i));
+		}
+		buffer += seprintf(buffer, last, "\n");
+	}
 
 	extern uint32 _frame_counter;
 
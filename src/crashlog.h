@@ -32,6 +32,7 @@ struct DesyncExtraInfo {
 	int client_id = -1;
 	uint32 desync_frame_seed = 0;
 	uint32 desync_frame_state_checksum = 0;
+	uint32 desync_frame_state_subsystems = 0; ///< bit mask of the StateChecksumSubsystem checksums which differed at desync_frame_state_checksum
 	FILE **log_file = nullptr; ///< save unclosed log file handle here
 	DesyncDeferredSaveInfo *defer_savegame_write = nullptr;
 };
@@ -48,6 +48,8 @@ namespace {
 	const int NUM_FRAMERATE_POINTS = 512;
 	/** %Units a second is divided into in performance measurements */
 	const TimingMeasurement TIMESTAMP_PRECISION = 1000000;
+	/** Whether all measurements are kept for a benchmark run, see BeginPerformanceBenchmark */
+	bool _benchmark_active = false;
 
 	struct PerformanceData {
 		/** Duration value indicating the value is not valid should be considered a gap in measurements */
@@ -71,6 +73,9 @@ namespace {
 		/** Start time for current accumulation cycle */
 		TimingMeasurement acc_timestamp;
 
+		/** All durations measured since the start of the benchmark run, not limited to \c NUM_FRAMERATE_POINTS */
+		std::vector<TimingMeasurement> benchmark_durations;
+
 		/**
 		 * Initialize a data element with an expected collection rate
 		 * @param expected_rate
@@ -88,6 +93,7 @@ namespace {
 			this->next_index += 1;
 			if (this->next_index >= NUM_FRAMERATE_POINTS) this->next_index = 0;
 			this->num_valid = std::min(NUM_FRAMERATE_POINTS, this->num_valid + 1);
+			if (_benchmark_active) this->benchmark_durations.push_back(end_time - start_time);
 		}
 
 		/** Begin an accumulation of multiple measurements into a single value, from a given start time */
@@ -99,6 +105,7 @@ namespace {
 			this->next_index += 1;
 			if (this->next_index >= NUM_FRAMERATE_POINTS) this->next_index = 0;
 			this->num_valid = std::min(NUM_FRAMERATE_POINTS, this->num_valid + 1);
+			if (_benchmark_active) this->benchmark_durations.push_back(this->acc_duration);
 
 			this->acc_duration = 0;
 			this->acc_timestamp = start_time;
@@ -196,6 +203,19 @@ namespace {
 		PerformanceData(1),                     // PFE_ACC_GL_SHIPS
 		PerformanceData(1),                     // PFE_ACC_GL_AIRCRAFT
 		PerformanceData(1),                     // PFE_GL_LANDSCAPE
+		PerformanceData(1),                     // PFE_GL_TILELOOP_CLEAR ...
+		PerformanceData(1),
+		PerformanceData(1),
+		PerformanceData(1),
+		PerformanceData(1),
+		PerformanceData(1),
+		PerformanceData(1),
+		PerformanceData(1),
+		PerformanceData(1),
+		PerformanceData(1),                     // PFE_GL_TILELOOP_OBJECT
+		PerformanceData(1),                     // PFE_GL_PF_TRAINS
+		PerformanceData(1),                     // PFE_GL_PF_ROADVEHS
+		PerformanceData(1),                     // PFE_GL_PF_SHIPS
 		PerformanceData(1),                     // PFE_GL_LINKGRAPH
 		PerformanceData(1000.0 / 30),           // PFE_DRAWING
 		PerformanceData(1),                     // PFE_ACC_DRAWWORLD
@@ -323,6 +343,115 @@ void PerformanceAccumulator::Reset(PerformanceElement elem)
 	_pf_data[elem].BeginAccumulate(GetPerformanceTimer());
 }
 
+/**
+ * Add a duration which was measured externally to the accumulating value of an element.
+ * @param elem The element to add the duration to
+ * @param ns Duration in nanoseconds
+ */
+void PerformanceAccumulator::AddNanoseconds(PerformanceElement elem, uint64 ns)
+{
+	_pf_data[elem].AddAccumulate((TimingMeasurement)(ns * TIMESTAMP_PRECISION / 1000000000));
+}
+
+
+/**
+ * Start keeping all measurements of all performance elements, for a benchmark run.
+ * The circular buffers used by the framerate window only hold the last \c NUM_FRAMERATE_POINTS measurements.
+ */
+void BeginPerformanceBenchmark()
+{
+	for (PerformanceData &data : _pf_data) {
+		data.benchmark_durations.clear();
+	}
+	_benchmark_active = true;
+}
+
+/**
+ * Stop keeping the measurements of a benchmark run and get their distribution.
+ * @return The distribution of the measurements of each element which was measured at least once.
+ */
+std::vector<PerformanceBenchmarkElement> EndPerformanceBenchmark()
+{
+	static const char * const BENCHMARK_KEYS[] = {
+		"gameloop",
+		"gl_economy",
+		"gl_trains",
+		"gl_roadvehs",
+		"gl_ships",
+		"gl_aircraft",
+		"gl_landscape",
+		"gl_tileloop_clear",
+		"gl_tileloop_rail",
+		"gl_tileloop_road",
+		"gl_tileloop_house",
+		"gl_tileloop_trees",
+		"gl_tileloop_station",
+		"gl_tileloop_water",
+		"gl_tileloop_industry",
+		"gl_tileloop_tunnelbridge",
+		"gl_tileloop_object",
+		"gl_pf_trains",
+		"gl_pf_roadvehs",
+		"gl_pf_ships",
+		"gl_linkgraph",
+		"drawing",
+		"drawworld",
+		"video",
+		"sound",
+		"allscripts",
+		"gamescript",
+		"ai0",
+		"ai1",
+		"ai2",
+		"ai3",
+		"ai4",
+		"ai5",
+		"ai6",
+		"ai7",
+		"ai8",
+		"ai9",
+		"ai10",
+		"ai11",
+		"ai12",
+		"ai13",
+		"ai14",
+	};
+	static_assert(lengthof(BENCHMARK_KEYS) == PFE_MAX);
+
+	_benchmark_active = false;
+
+	std::vector<PerformanceBenchmarkElement> result;
+	for (PerformanceElement e = PFE_FIRST; e < PFE_MAX; e++) {
+		std::vector<TimingMeasurement> &durations = _pf_data[e].benchmark_durations;
+		if (durations.empty()) continue;
+
+		std::sort(durations.begin(), durations.end());
+		auto to_ms = [](TimingMeasurement d) -> double { return (double)d * 1000 / TIMESTAMP_PRECISION; };
+		auto percentile = [&](uint p) -> double {
+			/* Nearest rank */
+			size_t rank = (durations.size() * p + 99) / 100;
+			return to_ms(durations[std::max<size_t>(rank, 1) - 1]);
+		};
+
+		double sum = 0;
+		for (TimingMeasurement d : durations) sum += d;
+
+		PerformanceBenchmarkElement &elem = result.emplace_back();
+		elem.elem = e;
+		elem.key = BENCHMARK_KEYS[e];
+		elem.samples = (uint)durations.size();
+		elem.avg_ms = to_ms(1) * sum / durations.size();
+		elem.p50_ms = percentile(50);
+		elem.p95_ms = percentile(95);
+		elem.p99_ms = percentile(99);
+		elem.max_ms = to_ms(durations.back());
+
+		durations.clear();
+		durations.shrink_to_fit();
+	}
+	return result;
+}
+
 
 void ShowFrametimeGraphWindow(PerformanceElement elem);
 
@@ -331,10 +460,23 @@ static const PerformanceElement DISPLAY_ORDER_PFE[PFE_MAX] = {
 	PFE_GAMELOOP,
 	PFE_GL_ECONOMY,
 	PFE_GL_TRAINS,
+	PFE_GL_PF_TRAINS,
 	PFE_GL_ROADVEHS,
+	PFE_GL_PF_ROADVEHS,
 	PFE_GL_SHIPS,
+	PFE_GL_PF_SHIPS,
 	PFE_GL_AIRCRAFT,
 	PFE_GL_LANDSCAPE,
+	PFE_GL_TILELOOP_CLEAR,
+	PFE_GL_TILELOOP_RAIL,
+	PFE_GL_TILELOOP_ROAD,
+	PFE_GL_TILELOOP_HOUSE,
+	PFE_GL_TILELOOP_TREES,
+	PFE_GL_TILELOOP_STATION,
+	PFE_GL_TILELOOP_WATER,
+	PFE_GL_TILELOOP_INDUSTRY,
+	PFE_GL_TILELOOP_TUNNELBRIDGE,
+	PFE_GL_TILELOOP_OBJECT,
 	PFE_ALLSCRIPTS,
 	PFE_GAMESCRIPT,
 	PFE_AI0,
@@ -1049,6 +1191,19 @@ void ConPrintFramerate()
 		"  GL ship ticks",
 		"  GL aircraft ticks",
 		"  GL landscape ticks",
+		"    GL tile loop: clear",
+		"    GL tile loop: rail",
+		"    GL tile loop: road",
+		"    GL tile loop: houses",
+		"    GL tile loop: trees",
+		"    GL tile loop: stations",
+		"    GL tile loop: water",
+		"    GL tile loop: industries",
+		"    GL tile loop: tunnels/bridges",
+		"    GL tile loop: objects",
+		"    GL pathfinder: trains",
+		"    GL pathfinder: road vehicles",
+		"    GL pathfinder: ships",
 		"  GL link graph delays",
 		"Drawing",
 		"  Viewport drawing",
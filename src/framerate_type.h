@@ -37,6 +37,7 @@
 
 #include "stdafx.h"
 #include "core/enum_type.hpp"
+#include <vector>
 
 /**
  * Elements of game performance that can be measured.
@@ -53,6 +54,19 @@ enum PerformanceElement {
 	PFE_GL_SHIPS,      ///< Time spent processing ships
 	PFE_GL_AIRCRAFT,   ///< Time spent processing aircraft
 	PFE_GL_LANDSCAPE,  ///< Time spent processing other world features
+	PFE_GL_TILELOOP_CLEAR,        ///< Time spent in tile loop procs of clear tiles (only when tile loop profiling is enabled)
+	PFE_GL_TILELOOP_RAIL,         ///< Time spent in tile loop procs of rail tiles (only when tile loop profiling is enabled)
+	PFE_GL_TILELOOP_ROAD,         ///< Time spent in tile loop procs of road tiles (only when tile loop profiling is enabled)
+	PFE_GL_TILELOOP_HOUSE,        ///< Time spent in tile loop procs of house tiles (only when tile loop profiling is enabled)
+	PFE_GL_TILELOOP_TREES,        ///< Time spent in tile loop procs of tree tiles (only when tile loop profiling is enabled)
+	PFE_GL_TILELOOP_STATION,      ///< Time spent in tile loop procs of station tiles (only when tile loop profiling is enabled)
+	PFE_GL_TILELOOP_WATER,        ///< Time spent in tile loop procs of water tiles (only when tile loop profiling is enabled)
+	PFE_GL_TILELOOP_INDUSTRY,     ///< Time spent in tile loop procs of industry tiles (only when tile loop profiling is enabled)
+	PFE_GL_TILELOOP_TUNNELBRIDGE, ///< Time spent in tile loop procs of tunnel and bridge tiles (only when tile loop profiling is enabled)
+	PFE_GL_TILELOOP_OBJECT,       ///< Time spent in tile loop procs of object tiles (only when tile loop profiling is enabled)
+	PFE_GL_PF_TRAINS,             ///< Time spent in YAPF searches for trains
+	PFE_GL_PF_ROADVEHS,           ///< Time spent in YAPF searches for road vehicles
+	PFE_GL_PF_SHIPS,              ///< Time spent in YAPF searches for ships
 	PFE_GL_LINKGRAPH,  ///< Time spent waiting for link graph background jobs
 	PFE_DRAWING,       ///< Speed of drawing world and GUI.
 	PFE_DRAWWORLD,     ///< Time spent drawing world viewports in GUI
@@ -118,9 +132,24 @@ public:
 	PerformanceAccumulator(PerformanceElement elem);
 	~PerformanceAccumulator();
 	static void Reset(PerformanceElement elem);
+	static void AddNanoseconds(PerformanceElement elem, uint64 ns);
+};
+
+/** Distribution of the measurements of a performance element during a benchmark run, see BeginPerformanceBenchmark. */
+struct PerformanceBenchmarkElement {
+	PerformanceElement elem; ///< The element.
+	const char *key;         ///< Machine readable name of the element.
+	uint samples;            ///< Number of measurements.
+	double avg_ms;           ///< Average duration.
+	double p50_ms;           ///< Median duration.
+	double p95_ms;           ///< 95th percentile duration.
+	double p99_ms;           ///< 99th percentile duration.
+	double max_ms;           ///< Longest duration.
 };
 
 void ShowFramerateWindow();
 void ProcessPendingPerformanceMeasurements();
+void BeginPerformanceBenchmark();
+std::vector<PerformanceBenchmarkElement> EndPerformanceBenchmark();
 
 #endif /* FRAMERATE_TYPE_H */
@@ -35,7 +35,16 @@
 #include "town.h"
 #include "3rdparty/cpp-btree/btree_set.h"
 #include "scope_info.h"
+#include "town_map.h"
+#include "house.h"
+#include "industry_map.h"
+#include "industrytype.h"
+#include "newgrf.h"
+#include "newgrf_config.h"
+#include "3rdparty/cpp-btree/btree_map.h"
+#include INCLUDE_FOR_PREFETCH_NTA
 #include <array>
+#include <chrono>
 #include <list>
 #include <set>
 #include <deque>
@@ -835,6 +844,280 @@ void SetupTileLoopCounts()
 	if (accumulator > 0) _tile_loop_counts[0]++;
 }
 
+/** Counter of tile loop proc calls and the time spent in them. */
+struct TileLoopProfileCounter {
+	uint64 calls = 0; ///< Number of tile loop proc calls.
+	uint64 ns = 0;    ///< Total time spent in the tile loop procs, in nanoseconds.
+
+	inline void Add(uint64 duration)
+	{
+		this->calls++;
+		this->ns += duration;
+	}
+};
+
+/** Tile loop profile counters collected over one window of ticks. */
+struct TileLoopProfileWindow {
+	std::array<TileLoopProfileCounter, 16> types;                      ///< Counters by tile type.
+	btree::btree_map<uint32, TileLoopProfileCounter> house_grfs;    ///< House tile counters by GRF ID, 0 for original houses.
+	btree::btree_map<uint32, TileLoopProfileCounter> industry_grfs; ///< Industry tile counters by GRF ID, 0 for original industry tiles.
+	uint ticks = 0;                                                   ///< Number of ticks in this window so far.
+};
+
+/** State of the optional tile loop profiler, see #SetTileLoopProfiling. */
+static struct TileLoopProfile {
+	bool enabled = false;                ///< Whether tile loop procs are currently being timed.
+	uint window_ticks = 0;               ///< Length of a profiling window in ticks.
+	bool have_last = false;              ///< Whether #last contains a complete window.
+	TileLoopProfileWindow current;       ///< Window currently being collected.
+	TileLoopProfileWindow last;          ///< Last complete window.
+	std::array<uint64, 16> tick_ns = {}; ///< Time spent per tile type in the current tick, in nanoseconds.
+} _tile_loop_profile;
+
+/** Performance element of each tile type, PFE_MAX for tile types without tile loop measurement. */
+static const PerformanceElement _tile_loop_profile_pfe[16] = {
+	PFE_GL_TILELOOP_CLEAR,
+	PFE_GL_TILELOOP_RAIL,
+	PFE_GL_TILELOOP_ROAD,
+	PFE_GL_TILELOOP_HOUSE,
+	PFE_GL_TILELOOP_TREES,
+	PFE_GL_TILELOOP_STATION,
+	PFE_GL_TILELOOP_WATER,
+	PFE_MAX,
+	PFE_GL_TILELOOP_INDUSTRY,
+	PFE_GL_TILELOOP_TUNNELBRIDGE,
+	PFE_GL_TILELOOP_OBJECT,
+	PFE_MAX, PFE_MAX, PFE_MAX, PFE_MAX, PFE_MAX,
+};
+
+/**
+ * Enable or disable timing of the tile loop procs by tile type and by NewGRF.
+ * This is purely local and does not affect the game state.
+ * @param enabled Whether to enable profiling.
+ * @param window_ticks Length of the window in ticks over which the counters are collected.
+ */
+void SetTileLoopProfiling(bool enabled, uint window_ticks)
+{
+	TileLoopProfile &profile = _tile_loop_profile;
+	for (PerformanceElement pfe : _tile_loop_profile_pfe) {
+		if (pfe == PFE_MAX) continue;
+		if (enabled && !profile.enabled) PerformanceAccumulator::Reset(pfe);
+		PerformanceMeasurer::SetInactive(pfe);
+	}
+
+	if (enabled && (!profile.enabled || window_ticks != profile.window_ticks)) {
+		profile.current = {};
+		profile.last = {};
+		profile.have_last = false;
+		profile.tick_ns = {};
+	}
+	profile.enabled = enabled;
+	profile.window_ticks = std::max<uint>(1, window_ticks);
+}
+
+/**
+ * Start a new game tick for the tile loop profiler.
+ * This feeds the time spent per tile type in the previous tick to the framerate window and advances the profiling window.
+ * @param paused Whether the game loop is paused this tick.
+ */
+void TileLoopProfileBeginTick(bool paused)
+{
+	TileLoopProfile &profile = _tile_loop_profile;
+	if (!profile.enabled) return;
+
+	for (uint type = 0; type < lengthof(_tile_loop_profile_pfe); type++) {
+		const PerformanceElement pfe = _tile_loop_profile_pfe[type];
+		if (pfe == PFE_MAX) continue;
+		if (paused) {
+			PerformanceMeasurer::Paused(pfe);
+		} else {
+			PerformanceAccumulator::AddNanoseconds(pfe, profile.tick_ns[type]);
+			PerformanceAccumulator::Reset(pfe);
+			profile.tick_ns[type] = 0;
+		}
+	}
+	if (paused) return;
+
+	if (profile.current.ticks >= profile.window_ticks) {
+		profile.last = std::move(profile.current);
+		profile.current = {};
+		profile.have_last = true;
+	}
+	profile.current.ticks++;
+}
+
+/**
+ * Call the tile loop proc of a tile and record the time spent in it.
+ * @param tile The tile to run the tile loop proc of.
+ */
+static void RunTileLoopProcProfiled(TileIndex tile)
+{
+	const TileType type = GetTileType(tile);
+
+	/* Resolve the NewGRF before running the tile loop, it may demolish the house or industry tile. */
+	TileLoopProfileCounter *grf_counter = nullptr;
+	if (type == MP_HOUSE) {
+		const GRFFile *grffile = HouseSpec::Get(GetHouseType(tile))->grf_prop.grffile;
+		grf_counter = &_tile_loop_profile.current.house_grfs[grffile != nullptr ? grffile->grfid : 0];
+	} else if (type == MP_INDUSTRY) {
+		const GRFFile *grffile = GetIndustryTileSpec(GetIndustryGfx(tile))->grf_prop.grffile;
+		grf_counter = &_tile_loop_profile.current.industry_grfs[grffile != nullptr ? grffile->grfid : 0];
+	}
+
+	const auto start = std::chrono::steady_clock::now();
+	_tile_type_procs[type]->tile_loop_proc(tile);
+	const uint64 ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+
+	_tile_loop_profile.current.types[type].Add(ns);
+	_tile_loop_profile.tick_ns[type] += ns;
+	if (grf_counter != nullptr) grf_counter->Add(ns);
+}
+
+static char *DumpTileLoopProfileWindow(char *b, const char *last, const TileLoopProfileWindow &window)
+{
+	static const char * const type_names[16] = {
+		"clear", "rail", "road", "houses", "trees", "stations", "water", "void",
+		"industries", "tunnels/bridges", "objects", "", "", "", "", "",
+	};
+
+	uint64 total_ns = 0;
+	uint64 total_calls = 0;
+	for (const TileLoopProfileCounter &counter : window.types) {
+		total_ns += counter.ns;
+		total_calls += counter.calls;
+	}
+
+	auto dump_counter = [&](const char *name, const TileLoopProfileCounter &counter) {
+		char calls[24];
+		seprintf(calls, lastof(calls), OTTD_PRINTF64U, counter.calls);
+		b += seprintf(b, last, "  %-20s %10s calls, %10.3f ms total, %7.3f ms/tick, %8.1f ns/call, %5.1f%%\n",
+				name, calls, counter.ns / 1000000.0, counter.ns / 1000000.0 / std::max<uint>(1, window.ticks),
+				counter.calls > 0 ? (double)counter.ns / counter.calls : 0.0, total_ns > 0 ? counter.ns * 100.0 / total_ns : 0.0);
+	};
+
+	std::vector<uint> types;
+	for (uint type = 0; type < window.types.size(); type++) {
+		if (window.types[type].calls > 0) types.push_back(type);
+	}
+	std::sort(types.begin(), types.end(), [&](uint x, uint y) {
+		return window.types[x].ns > window.types[y].ns;
+	});
+	for (uint type : types) {
+		dump_counter(type_names[type], window.types[type]);
+	}
+	dump_counter("total", { total_calls, total_ns });
+
+	auto dump_grfs = [&](const char *title, const btree::btree_map<uint32, TileLoopProfileCounter> &grfs) {
+		if (grfs.empty()) return;
+		b += seprintf(b, last, "%s by NewGRF:\n", title);
+
+		std::vector<std::pair<uint32, TileLoopProfileCounter>> sorted(grfs.begin(), grfs.end());
+		std::sort(sorted.begin(), sorted.end(), [](const auto &x, const auto &y) {
+			return x.second.ns > y.second.ns;
+		});
+		for (const auto &it : sorted) {
+			char name[64];
+			if (it.first == 0) {
+				strecpy(name, "original", lastof(name));
+			} else {
+				const GRFConfig *config = GetGRFConfig(it.first);
+				seprintf(name, lastof(name), "%08X", BSWAP32(it.first));
+				if (config != nullptr) b += seprintf(b, last, "  [%s] %s\n", name, config->GetName());
+			}
+			dump_counter(name, it.second);
+		}
+	};
+	dump_grfs("Houses", window.house_grfs);
+	dump_grfs("Industry tiles", window.industry_grfs);
+
+	return b;
+}
+
+/**
+ * Dump the tile loop profile counters.
+ * The last complete window is shown if there is one, otherwise the window currently being collected.
+ */
+void DumpTileLoopProfile(char *b, const char *last)
+{
+	const TileLoopProfile &profile = _tile_loop_profile;
+	if (!profile.enabled) {
+		b += seprintf(b, last, "Tile loop profiling is not enabled\n");
+		return;
+	}
+
+	if (profile.have_last) {
+		b += seprintf(b, last, "Tile loop profile, last complete window of %u ticks:\n", profile.last.ticks);
+		b = DumpTileLoopProfileWindow(b, last, profile.last);
+	} else {
+		b += seprintf(b, last, "Tile loop profile, incomplete window: %u of %u ticks:\n", profile.current.ticks, profile.window_ticks);
+		b = DumpTileLoopProfileWindow(b, last, profile.current);
+	}
+}
+
+/** Number of LFSR steps by which the tile loop prefetches map entries ahead of the tile being processed. */
+static const uint TILE_LOOP_PREFETCH_DISTANCE = 8;
+
+/**
+ * Run the tile loop procs of a number of tiles, following the tile loop LFSR.
+ * @tparam profiled Whether to time the tile loop procs, see #SetTileLoopProfiling.
+ * @param tile The first tile to run the tile loop proc of.
+ * @param count The number of tiles to run the tile loop proc of.
+ * @param feedback The feedback of the tile loop LFSR.
+ * @return The next tile to run the tile loop proc of.
+ */
+template <bool profiled>
+static TileIndex RunTileLoopProcs(TileIndex tile, uint count, uint32 feedback)
+{
+	auto tile_loop_proc = [](TileIndex t) {
+		if (profiled) {
+			RunTileLoopProcProfiled(t);
+		} else {
+			_tile_type_procs[GetTileType(t)]->tile_loop_proc(t);
+		}
+	};
+
+	/*
+	 * The LFSR visits tiles in an effectively random order, so nearly every tile access is a cache miss.
+	 * Run a second copy of the LFSR a few steps ahead and prefetch the map entries it reaches, so that they are
+	 * (hopefully) in cache by the time the tile loop proc gets to them. The order in which tiles are processed
+	 * is unchanged, as it determines the order of Random() calls.
+	 */
+	auto next_tile = [feedback](TileIndex t) -> TileIndex {
+		return (t >> 1) ^ (-(int32)(t & 1) & feedback);
+	};
+	TileIndex ahead = tile;
+	for (uint i = 0; i < TILE_LOOP_PREFETCH_DISTANCE; i++) {
+		PREFETCH_NTA(&_m[ahead]);
+#ifdef WITH_SPLIT_MAP_ARRAYS
+		PREFETCH_NTA(&_m_type[ahead]);
+#endif
+		PREFETCH_NTA(&_me[ahead]);
+		ahead = next_tile(ahead);
+	}
+
+	/* Manually update tile 0 every 256 ticks - the LFSR never iterates over it itself.  */
+	if (_tick_counter % 256 == 0) {
+		tile_loop_proc(0);
+		count--;
+	}
+
+	while (count--) {
+		PREFETCH_NTA(&_m[ahead]);
+#ifdef WITH_SPLIT_MAP_ARRAYS
+		PREFETCH_NTA(&_m_type[ahead]);
+#endif
+		PREFETCH_NTA(&_me[ahead]);
+		ahead = next_tile(ahead);
+
+		tile_loop_proc(tile);
+
+		/* Get the next tile in sequence using a Galois LFSR. */
+		tile = next_tile(tile);
+	}
+
+	return tile;
+}
+
 /**
  * Gradually iterate over all tiles on the map, calling their TileLoopProcs once every 256 ticks.
  */
@@ -859,20 +1142,11 @@ void RunTileLoop(bool apply_day_length)
 
 	SCOPE_INFO_FMT([&], "RunTileLoop: tile: %dx%d", TileX(tile), TileY(tile));
 
-	/* Manually update tile 0 every 256 ticks - the LFSR never iterates over it itself.  */
-	if (_tick_counter % 256 == 0) {
-		_tile_type_procs[GetTileType(0)]->tile_loop_proc(0);
-		count--;
-	}
-
-	while (count--) {
-		_tile_type_procs[GetTileType(tile)]->tile_loop_proc(tile);
-
-		/* Get the next tile in sequence using a Galois LFSR. */
-		tile = (tile >> 1) ^ (-(int32)(tile & 1) & feedback);
+	if (unlikely(_tile_loop_profile.enabled)) {
+		_cur_tileloop_tile = RunTileLoopProcs<true>(tile, count, feedback);
+	} else {
+		_cur_tileloop_tile = RunTileLoopProcs<false>(tile, count, feedback);
 	}
-
-	_cur_tileloop_tile = tile;
 }
 
 void RunAuxiliaryTileLoop()
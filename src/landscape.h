@@ -170,6 +170,9 @@ void DoClearSquare(TileIndex tile);
 void SetupTileLoopCounts();
 void RunTileLoop(bool apply_day_length = false);
 void RunAuxiliaryTileLoop();
+void SetTileLoopProfiling(bool enabled, uint window_ticks);
+void TileLoopProfileBeginTick(bool paused);
+void DumpTileLoopProfile(char *b, const char *last);
 
 void InitializeLandscape();
 void GenerateLandscape(byte mode);
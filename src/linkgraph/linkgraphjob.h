@@ -292,6 +292,23 @@ public:
 	 */
 	inline void AbortJob() { this->job_aborted.store(true, std::memory_order_release); }
 
+	/**
+	 * Get the index of an edge annotation of this job, for use with per-edge data stored outside of the job.
+	 * @param edge Edge annotation.
+	 * @return Index of the edge annotation, or UINT_MAX if it does not belong to this job.
+	 */
+	inline uint GetEdgeIndex(const Edge &edge) const
+	{
+		if (this->edges.empty() || &edge < this->edges.data() || &edge >= this->edges.data() + this->edges.size()) return UINT_MAX;
+		return (uint)(&edge - this->edges.data());
+	}
+
+	/**
+	 * Get the number of edge annotations of this job.
+	 * @return Number of edge annotations.
+	 */
+	inline uint GetEdgeCount() const { return (uint)this->edges.size(); }
+
 	/**
 	 * Check if job is supposed to be finished.
 	 * @param tick_offset Optional number of ticks to add to the current date
@@ -436,6 +453,13 @@ public:
 	uint AddFlow(uint f, LinkGraphJob &job, uint max_saturation);
 	void Fork(Path *base, uint cap, int free_cap, uint dist);
 
+	/**
+	 * Replace the parent leg of this one, without changing any child counts.
+	 * This is only for moving a whole path tree to different storage.
+	 * @param parent New parent leg.
+	 */
+	inline void ReplaceParent(Path *parent) { this->SetParent(parent); }
+
 	inline bool GetAnnosSetFlag() const { return HasBit(this->parent_storage, 0); }
 	inline void SetAnnosSetFlag(bool flag) { SB(this->parent_storage, 0, 1, flag ? 1 : 0); }
 
@@ -17,9 +17,17 @@
 #include "../command_func.h"
 #include "../network/network.h"
 #include <algorithm>
+#include <chrono>
 
 #include "../safeguards.h"
 
+/**
+ * Worker pool which link graph job groups are run on.
+ * This is separate from the general worker pool as link graph jobs may run for a long time.
+ * This is defined before LinkGraphSchedule::instance, such that it is destroyed after any remaining jobs.
+ */
+WorkerThreadPool _link_graph_worker_pool;
+
 /**
  * Static instance of LinkGraphSchedule.
  * Note: This instance is created on task start.
@@ -27,6 +35,9 @@
  */
 /* static */ LinkGraphSchedule LinkGraphSchedule::instance;
 
+/* Initial value chosen such that the initial group cost budget is 200000. */
+/* static */ std::atomic<uint64> LinkGraphJobGroup::ns_per_kilocost(102400);
+
 /**
  * Start the next job(s) in the schedule.
  *
@@ -228,64 +239,79 @@ LinkGraphSchedule::~LinkGraphSchedule()
 }
 
 LinkGraphJobGroup::LinkGraphJobGroup(constructor_token token, std::vector<LinkGraphJob *> jobs) :
-	jobs(std::move(jobs)) { }
+	task(_link_graph_worker_pool), jobs(std::move(jobs)) { }
 
 void LinkGraphJobGroup::SpawnThread()
 {
 	/**
-	 * Spawn a thread if possible and run the link graph job in the thread. If
-	 * that's not possible run the job right now in the current thread.
+	 * Run the link graph jobs on the link graph worker pool. The pool is started on first use,
+	 * with at least one worker such that jobs are not run in the main thread. If no worker thread
+	 * could be started, the jobs are run right now in the current thread.
 	 */
-	if (StartNewThread(&this->thread, "ottd:linkgraph", &(LinkGraphJobGroup::Run), this)) {
-		for (auto &it : this->jobs) {
-			it->SetJobGroup(this->shared_from_this());
-		}
-	} else {
-		/* Of course this will hang a bit.
-		 * On the other hand, if you want to play games which make this hang noticably
-		 * on a platform without threads then you'll probably get other problems first.
-		 * OK:
-		 * If someone comes and tells me that this hangs for them, I'll implement a
-		 * smaller grained "Step" method for all handlers and add some more ticks where
-		 * "Step" is called. No problem in principle. */
-		LinkGraphJobGroup::Run(this);
+	_link_graph_worker_pool.Start("ottd:linkgraph", 16, 1);
+
+	for (auto &it : this->jobs) {
+		it->SetJobGroup(this->shared_from_this());
 	}
+	this->task.Run([this]() {
+		LinkGraphJobGroup::Run(this);
+	});
 }
 
 void LinkGraphJobGroup::JoinThread()
 {
-	if (this->thread.joinable()) {
-		this->thread.join();
-	}
+	/* Do not use Wait, that would run the jobs here if no worker has started them yet. */
+	this->task.WaitForCompletion();
 }
 
 /**
- * Run all jobs for the given LinkGraphJobGroup. This method is tailored to
- * ThreadObject::New.
- * @param j Pointer to a LinkGraphJobGroup.
+ * Run all jobs for the given LinkGraphJobGroup, and update the measured run time per unit of cost estimate.
+ * @param group Pointer to a LinkGraphJobGroup.
  */
 /* static */ void LinkGraphJobGroup::Run(void *group)
 {
 	LinkGraphJobGroup *job_group = (LinkGraphJobGroup *)group;
 	for (LinkGraphJob *job : job_group->jobs) {
+		const auto start = std::chrono::steady_clock::now();
 		LinkGraphSchedule::Run(job);
+		const uint64 cost = job->Graph().CalculateCostEstimate();
+		if (job->IsJobAborted() || cost < 1024) continue;
+
+		const uint64 ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+		const uint64 sample = std::max<uint64>(1, ns / (cost / 1024));
+
+		/* Exponential moving average. Concurrent updates may be lost, this is only a scheduling hint. */
+		const uint64 old_value = ns_per_kilocost.load(std::memory_order_relaxed);
+		ns_per_kilocost.store(old_value - (old_value / 8) + (sample / 8), std::memory_order_relaxed);
 	}
 }
 
+/**
+ * Get the cost estimate budget of a job group, such that the group is expected to run for about 20ms.
+ * This does not affect the game state, only how jobs are combined into groups.
+ * @return Cost estimate budget.
+ */
+/* static */ uint64 LinkGraphJobGroup::GetGroupCostBudget()
+{
+	const uint64 target_ns = 20000000;
+	const uint64 budget = (target_ns * 1024) / std::max<uint64>(1, ns_per_kilocost.load(std::memory_order_relaxed));
+	return Clamp<uint64>(budget, 200000 / 16, 200000 * 16);
+}
+
 /* static */ void LinkGraphJobGroup::ExecuteJobSet(std::vector<JobInfo> jobs) {
-	const uint thread_budget = 200000;
+	const uint64 thread_budget = LinkGraphJobGroup::GetGroupCostBudget();
 
 	std::sort(jobs.begin(), jobs.end(), [](const JobInfo &a, const JobInfo &b) {
 		return std::make_pair(a.job->JoinDateTicks(), a.cost_estimate) < std::make_pair(b.job->JoinDateTicks(), b.cost_estimate);
 	});
 
 	std::vector<LinkGraphJob *> bucket;
-	uint bucket_cost = 0;
+	uint64 bucket_cost = 0;
 	DateTicks bucket_join_date = 0;
 	auto flush_bucket = [&]() {
 		if (!bucket_cost) return;
-		DEBUG(linkgraph, 2, "LinkGraphJobGroup::ExecuteJobSet: Creating Job Group: jobs: " PRINTF_SIZE ", cost: %u, join after: %d",
-				bucket.size(), bucket_cost, bucket_join_date - ((_date * DAY_TICKS) + _date_fract));
+		DEBUG(linkgraph, 2, "LinkGraphJobGroup::ExecuteJobSet: Creating Job Group: jobs: " PRINTF_SIZE ", cost: " OTTD_PRINTF64U ", budget: " OTTD_PRINTF64U ", join after: %d",
+				bucket.size(), bucket_cost, thread_budget, bucket_join_date - ((_date * DAY_TICKS) + _date_fract));
 		auto group = std::make_shared<LinkGraphJobGroup>(constructor_token(), std::move(bucket));
 		group->SpawnThread();
 		bucket_cost = 0;
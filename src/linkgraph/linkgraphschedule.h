@@ -10,7 +10,7 @@
 #ifndef LINKGRAPHSCHEDULE_H
 #define LINKGRAPHSCHEDULE_H
 
-#include "../thread.h"
+#include "../worker_thread.h"
 #include "linkgraph.h"
 #include <memory>
 #include <vector>
@@ -89,30 +89,35 @@ class LinkGraphJobGroup : public std::enable_shared_from_this<LinkGraphJobGroup>
 	friend LinkGraphJob;
 
 private:
-	std::thread thread;                      ///< Thread the job group is running in or nullptr if it's running in the main thread.
+	WorkerThreadPool::TaskGroup task;        ///< Task running the job group on _link_graph_worker_pool.
 	const std::vector<LinkGraphJob *> jobs;  ///< The set of jobs in this job set
 
+	static std::atomic<uint64> ns_per_kilocost; ///< Measured run time in nanoseconds per 1024 units of cost estimate.
+
 private:
 	struct constructor_token { };
 	static void Run(void *group);
 	void SpawnThread();
 	void JoinThread();
+	static uint64 GetGroupCostBudget();
 
 public:
 	LinkGraphJobGroup(constructor_token token, std::vector<LinkGraphJob *> jobs);
 
 	struct JobInfo {
 		LinkGraphJob * job;
-		uint cost_estimate;
+		uint64 cost_estimate;
 
 		JobInfo(LinkGraphJob *job);
-		JobInfo(LinkGraphJob *job, uint cost_estimate) :
+		JobInfo(LinkGraphJob *job, uint64 cost_estimate) :
 				job(job), cost_estimate(cost_estimate) { }
 	};
 
 	static void ExecuteJobSet(std::vector<JobInfo> jobs);
 };
 
+extern WorkerThreadPool _link_graph_worker_pool;
+
 void StateGameLoop_LinkGraphPauseControl();
 void AfterLoad_LinkGraphPauseControl();
 
@@ -3,7 +3,11 @@
 #include "../stdafx.h"
 #include "../core/math_func.hpp"
 #include "mcf.h"
+#include "../debug.h"
+#include "../string_func.h"
 #include "../3rdparty/cpp-btree/btree_map.h"
+#include <chrono>
+#include <random>
 #include <set>
 
 #include "../safeguards.h"
@@ -54,6 +58,20 @@ public:
 	 */
 	inline void UpdateAnnotation() { }
 
+	/**
+	 * Get the state of an edge which the result of Dijkstra depends on.
+	 * Only whether the edge has free capacity left is relevant for this annotation.
+	 * @param edge Edge.
+	 * @param capacity Usable capacity of the edge.
+	 * @return Edge state.
+	 */
+	static uint GetEdgeState(const Edge &edge, uint capacity)
+	{
+		int free_cap = capacity - edge.Flow();
+		if (free_cap > 0) return 1;
+		return free_cap == INT_MIN ? 2 : 0;
+	}
+
 	/**
 	 * Comparator for std containers.
 	 */
@@ -97,6 +115,18 @@ public:
 		this->cached_annotation = this->GetCapacityRatio();
 	}
 
+	/**
+	 * Get the state of an edge which the result of Dijkstra depends on.
+	 * The capacity ratio depends on the exact flow of the edge.
+	 * @param edge Edge.
+	 * @param capacity Usable capacity of the edge.
+	 * @return Edge state.
+	 */
+	static uint GetEdgeState(const Edge &edge, uint capacity)
+	{
+		return edge.Flow();
+	}
+
 	/**
 	 * Comparator for std containers.
 	 */
@@ -280,63 +310,331 @@ bool CapacityAnnotation::IsBetter(const CapacityAnnotation *base, uint cap,
 	}
 }
 
+/**
+ * Priority queue for the Dijkstra algorithm based on a btree_set of annotations.
+ * An annotation is erased before it is changed and inserted again afterwards.
+ * @tparam Tannotation Annotation to be used.
+ */
+template<class Tannotation>
+class AnnoSetQueue {
+	typedef btree::btree_set<AnnoSetItem<Tannotation>, typename Tannotation::Comparator> AnnoSet;
+	AnnoSet annos;
+
+public:
+	AnnoSetQueue(uint size) : annos(typename Tannotation::Comparator()) {}
+
+	inline bool IsEmpty() const { return this->annos.empty(); }
+
+	/**
+	 * Remove the best annotation from the queue.
+	 * @return Best annotation.
+	 */
+	inline Tannotation *Pop()
+	{
+		typename AnnoSet::iterator i = this->annos.begin();
+		Tannotation *anno = i->anno_ptr;
+		this->annos.erase(i);
+		return anno;
+	}
+
+	/**
+	 * Called before the annotation of a node is changed.
+	 * @param anno Annotation.
+	 */
+	inline void PrepareUpdate(Tannotation *anno)
+	{
+		if (anno->GetAnnosSetFlag()) this->annos.erase(AnnoSetItem<Tannotation>(anno));
+	}
+
+	/**
+	 * Insert an annotation into the queue, or update its position after it was changed.
+	 * @param anno Annotation.
+	 */
+	inline void Update(Tannotation *anno)
+	{
+		this->annos.insert(AnnoSetItem<Tannotation>(anno));
+		anno->SetAnnosSetFlag(true);
+	}
+};
+
+/**
+ * Priority queue for the Dijkstra algorithm based on an indexed d-ary heap, with the position of
+ * each node in the heap stored such that annotations can be updated in place.
+ * This does not allocate per operation, and the order in which annotations are popped is the same
+ * as for AnnoSetQueue, as both use the strict total order of Tannotation::Comparator.
+ * @tparam Tannotation Annotation to be used.
+ * @tparam Tarity Number of children of each heap node.
+ */
+template<class Tannotation, uint Tarity = 4>
+class AnnoHeapQueue {
+	typedef AnnoSetItem<Tannotation> Item;
+
+	std::vector<Item> heap;      ///< Heap of queued annotations.
+	std::vector<uint> position;  ///< Position in the heap per node, UINT_MAX if not queued.
+	typename Tannotation::Comparator before;
+
+	inline void Place(uint pos, const Item &item)
+	{
+		this->heap[pos] = item;
+		this->position[item.node_id] = pos;
+	}
+
+	void SiftUp(uint pos)
+	{
+		Item item = this->heap[pos];
+		while (pos > 0) {
+			uint parent = (pos - 1) / Tarity;
+			if (!this->before(item, this->heap[parent])) break;
+			this->Place(pos, this->heap[parent]);
+			pos = parent;
+		}
+		this->Place(pos, item);
+	}
+
+	void SiftDown(uint pos)
+	{
+		Item item = this->heap[pos];
+		const uint count = (uint)this->heap.size();
+		while (true) {
+			uint first_child = (pos * Tarity) + 1;
+			if (first_child >= count) break;
+			uint best = first_child;
+			const uint last_child = std::min(first_child + Tarity, count);
+			for (uint child = first_child + 1; child < last_child; child++) {
+				if (this->before(this->heap[child], this->heap[best])) best = child;
+			}
+			if (!this->before(this->heap[best], item)) break;
+			this->Place(pos, this->heap[best]);
+			pos = best;
+		}
+		this->Place(pos, item);
+	}
+
+public:
+	AnnoHeapQueue(uint size) : position(size, UINT_MAX) {}
+
+	inline bool IsEmpty() const { return this->heap.empty(); }
+
+	/**
+	 * Remove the best annotation from the queue.
+	 * @return Best annotation.
+	 */
+	inline Tannotation *Pop()
+	{
+		Tannotation *anno = this->heap.front().anno_ptr;
+		this->position[this->heap.front().node_id] = UINT_MAX;
+		Item last = this->heap.back();
+		this->heap.pop_back();
+		if (!this->heap.empty()) {
+			this->Place(0, last);
+			this->SiftDown(0);
+		}
+		return anno;
+	}
+
+	/**
+	 * Called before the annotation of a node is changed.
+	 * @param anno Annotation.
+	 */
+	inline void PrepareUpdate(Tannotation *anno) {}
+
+	/**
+	 * Insert an annotation into the queue, or update its position after it was changed.
+	 * @param anno Annotation.
+	 */
+	inline void Update(Tannotation *anno)
+	{
+		Item item(anno);
+		uint pos = this->position[item.node_id];
+		if (pos == UINT_MAX) {
+			this->heap.push_back(item);
+			pos = (uint)this->heap.size() - 1;
+			this->Place(pos, item);
+			this->SiftUp(pos);
+		} else {
+			this->Place(pos, item);
+			this->SiftUp(pos);
+			this->SiftDown(this->position[item.node_id]);
+		}
+	}
+};
+
+/** Priority queue used by the MCF passes. */
+template<class Tannotation>
+using DijkstraQueue = AnnoHeapQueue<Tannotation>;
+
 /**
  * A slightly modified Dijkstra algorithm. Grades the paths not necessarily by
  * distance, but by the value Tannotation computes. It uses the max_saturation
  * setting to artificially decrease capacities.
  * @tparam Tannotation Annotation to be used.
  * @tparam Tedge_iterator Iterator to be used for getting outgoing edges.
+ * @tparam Tqueue Priority queue of annotations, AnnoSetQueue or AnnoHeapQueue.
  * @param source_node Node where the algorithm starts.
  * @param paths Container for the paths to be calculated.
+ * @param allocator Allocator for the paths.
+ * @param edges_read If not nullptr, the indices of all edges read are appended to this.
  */
-template<class Tannotation, class Tedge_iterator>
-void MultiCommodityFlow::Dijkstra(NodeID source_node, PathVector &paths)
+template<class Tannotation, class Tedge_iterator, class Tqueue>
+void MultiCommodityFlow::Dijkstra(NodeID source_node, PathVector &paths, DynUniformArenaAllocator &allocator, std::vector<uint> *edges_read)
 {
-	typedef btree::btree_set<AnnoSetItem<Tannotation>, typename Tannotation::Comparator> AnnoSet;
-	AnnoSet annos = AnnoSet(typename Tannotation::Comparator());
 	Tedge_iterator iter(this->job);
 	uint size = this->job.Size();
+	Tqueue annos(size);
 	paths.resize(size, nullptr);
 
-	this->job.path_allocator.SetParameters(sizeof(Tannotation), (8192 - 32) / sizeof(Tannotation));
+	allocator.SetParameters(sizeof(Tannotation), (8192 - 32) / sizeof(Tannotation));
 
 	for (NodeID node = 0; node < size; ++node) {
-		Tannotation *anno = new (this->job.path_allocator.Allocate()) Tannotation(node, node == source_node);
+		Tannotation *anno = new (allocator.Allocate()) Tannotation(node, node == source_node);
 		anno->UpdateAnnotation();
-		if (node == source_node) {
-			annos.insert(AnnoSetItem<Tannotation>(anno));
-			anno->SetAnnosSetFlag(true);
-		}
+		if (node == source_node) annos.Update(anno);
 		paths[node] = anno;
 	}
-	while (!annos.empty()) {
-		typename AnnoSet::iterator i = annos.begin();
-		Tannotation *source = i->anno_ptr;
-		annos.erase(i);
+	while (!annos.IsEmpty()) {
+		Tannotation *source = annos.Pop();
 		NodeID from = source->GetNode();
 		iter.SetNode(source_node, from);
 		for (NodeID to = iter.Next(); to != INVALID_NODE; to = iter.Next()) {
 			if (to == from) continue; // Not a real edge but a consumption sign.
 			const Edge &edge = iter.SavedEdge() ? iter.GetSavedEdge() : this->job[from].GetEdgeTo(to);
-			uint capacity = edge.Capacity();
-			if (this->max_saturation != UINT_MAX) {
-				capacity *= this->max_saturation;
-				capacity /= 100;
-				if (capacity == 0) capacity = 1;
-			}
+			if (edges_read != nullptr) edges_read->push_back(this->job.GetEdgeIndex(edge));
+			uint capacity = this->GetUsableCapacity(edge);
 
 			Tannotation *dest = static_cast<Tannotation *>(paths[to]);
 			if (dest->IsBetter(source, capacity, capacity - edge.Flow(), edge.DistanceAnno())) {
-				if (dest->GetAnnosSetFlag()) annos.erase(AnnoSetItem<Tannotation>(dest));
+				annos.PrepareUpdate(dest);
 				dest->Fork(source, capacity, capacity - edge.Flow(), edge.DistanceAnno());
 				dest->UpdateAnnotation();
-				annos.insert(AnnoSetItem<Tannotation>(dest));
-				dest->SetAnnosSetFlag(true);
+				annos.Update(dest);
 			}
 		}
 	}
 }
 
+/**
+ * Get the capacity of an edge which may be used, according to max_saturation.
+ * @param edge Edge.
+ * @return Usable capacity.
+ */
+uint MultiCommodityFlow::GetUsableCapacity(const Edge &edge) const
+{
+	uint capacity = edge.Capacity();
+	if (this->max_saturation != UINT_MAX) {
+		capacity *= this->max_saturation;
+		capacity /= 100;
+		if (capacity == 0) capacity = 1;
+	}
+	return capacity;
+}
+
+/**
+ * Check whether paths calculated in advance are still valid, i.e. whether none of the edges read by
+ * Dijkstra have changed in a way which affects its result since the start of the current batch.
+ * @param speculative Paths calculated in advance.
+ * @return True if the paths can be used.
+ */
+bool MultiCommodityFlow::IsSpeculationValid(const SpeculativePaths &speculative) const
+{
+	for (uint edge : speculative.edges_read) {
+		if (edge == UINT_MAX || this->edge_changed[edge] == this->batch_id) return false;
+	}
+	return true;
+}
+
+/**
+ * Move paths calculated in advance to the job's path allocator.
+ * @param speculative Paths calculated in advance.
+ * @param paths Container for the moved paths.
+ */
+template<class Tannotation>
+void MultiCommodityFlow::MoveSpeculativePaths(SpeculativePaths &speculative, PathVector &paths)
+{
+	const uint size = (uint)speculative.paths.size();
+	paths.resize(size, nullptr);
+	this->job.path_allocator.SetParameters(sizeof(Tannotation), (8192 - 32) / sizeof(Tannotation));
+	for (uint node = 0; node < size; ++node) {
+		paths[node] = new (this->job.path_allocator.Allocate()) Tannotation(*static_cast<Tannotation *>(speculative.paths[node]));
+	}
+	for (uint node = 0; node < size; ++node) {
+		Path *parent = speculative.paths[node]->GetParent();
+		if (parent != nullptr) paths[node]->ReplaceParent(paths[parent->GetNode()]);
+	}
+	speculative.paths.clear();
+	speculative.allocator.EmptyArena();
+}
+
+/**
+ * Run Dijkstra for each source node which is not finished, in order, and process the resulting paths.
+ *
+ * For large enough jobs, Dijkstra is run in advance for batches of upcoming sources in parallel on the
+ * link graph worker pool. Processing a source changes edge flows, which later sources depend on. Therefore
+ * the changes of edge states relevant to Dijkstra are tracked, and paths calculated in advance are only used
+ * if none of the edges read were changed since the start of the batch. Otherwise Dijkstra is run again.
+ * The result is identical to calculating the paths of each source just before processing it.
+ * @param finished_sources Source nodes to skip.
+ * @param process_source Function called as process_source(source, paths) for each source in order, which must call CleanupPaths.
+ */
+template<class Tannotation, class Tedge_iterator, class Tprocess>
+void MultiCommodityFlow::ForEachSource(const std::vector<bool> &finished_sources, Tprocess process_source)
+{
+	const uint16 size = this->job.Size();
+	PathVector paths;
+
+	const uint workers = _link_graph_worker_pool.WorkerCount();
+	if (size < MIN_SPECULATIVE_SIZE || workers < 2) {
+		for (NodeID source = 0; source < size; ++source) {
+			if (finished_sources[source]) continue;
+			this->Dijkstra<Tannotation, Tedge_iterator, DijkstraQueue<Tannotation>>(source, paths, this->job.path_allocator, nullptr);
+			process_source(source, paths);
+		}
+		return;
+	}
+
+	this->edge_state_proc = &Tannotation::GetEdgeState;
+	if (this->edge_changed.size() != this->job.GetEdgeCount()) {
+		this->edge_changed.assign(this->job.GetEdgeCount(), 0);
+	}
+
+	std::vector<SpeculativePaths> speculative(std::min<uint>(workers * 2, MAX_SPECULATIVE_BATCH));
+	std::vector<NodeID> batch;
+	NodeID next = 0;
+	while (next < size) {
+		batch.clear();
+		for (; next < size && batch.size() < speculative.size(); ++next) {
+			if (!finished_sources[next]) batch.push_back(next);
+		}
+		if (batch.empty()) break;
+
+		this->batch_id++;
+		_link_graph_worker_pool.ParallelFor(1, batch.size(), 1, [&](size_t begin, size_t end) {
+			for (size_t i = begin; i < end; i++) {
+				speculative[i].edges_read.clear();
+				this->Dijkstra<Tannotation, Tedge_iterator, DijkstraQueue<Tannotation>>(batch[i], speculative[i].paths, speculative[i].allocator, &speculative[i].edges_read);
+			}
+		});
+
+		/* The first source of the batch does not depend on any other source of the batch. */
+		this->Dijkstra<Tannotation, Tedge_iterator, DijkstraQueue<Tannotation>>(batch[0], paths, this->job.path_allocator, nullptr);
+		process_source(batch[0], paths);
+
+		for (size_t i = 1; i < batch.size(); i++) {
+			if (this->IsSpeculationValid(speculative[i])) {
+				this->MoveSpeculativePaths<Tannotation>(speculative[i], paths);
+				this->speculation_hits++;
+			} else {
+				speculative[i].paths.clear();
+				speculative[i].allocator.EmptyArena();
+				this->Dijkstra<Tannotation, Tedge_iterator, DijkstraQueue<Tannotation>>(batch[i], paths, this->job.path_allocator, nullptr);
+				this->speculation_misses++;
+			}
+			process_source(batch[i], paths);
+		}
+	}
+
+	this->edge_state_proc = nullptr;
+}
+
 /**
  * Clean up paths that lead nowhere and the root path.
  * @param source_id ID of the root node.
@@ -379,8 +677,27 @@ uint MultiCommodityFlow::PushFlow(DemandAnnotation &anno, Path *path, uint min_s
 {
 	dbg_assert(anno.unsatisfied_demand > 0);
 	uint flow = std::min(std::max(anno.demand / accuracy, min_step_size), anno.unsatisfied_demand);
+
+	if (this->edge_state_proc != nullptr) {
+		/* Record the state of the edges along the path, to find the edges whose state is changed by this. */
+		this->pushed_edges.clear();
+		for (Path *leg = path; leg->GetParent() != nullptr; leg = leg->GetParent()) {
+			Edge &edge = this->job[leg->GetParent()->GetNode()].GetEdgeTo(leg->GetNode());
+			this->pushed_edges.push_back({ &edge, this->edge_state_proc(edge, this->GetUsableCapacity(edge)) });
+		}
+	}
+
 	flow = path->AddFlow(flow, this->job, max_saturation);
 	anno.unsatisfied_demand -= flow;
+
+	if (this->edge_state_proc != nullptr && flow > 0) {
+		for (const EdgeState &it : this->pushed_edges) {
+			if (this->edge_state_proc(*it.edge, this->GetUsableCapacity(*it.edge)) == it.state) continue;
+			uint index = this->job.GetEdgeIndex(*it.edge);
+			if (index != UINT_MAX) this->edge_changed[index] = this->batch_id;
+		}
+	}
+
 	return flow;
 }
 
@@ -535,7 +852,6 @@ bool MCF1stPass::EliminateCycles()
  */
 MCF1stPass::MCF1stPass(LinkGraphJob &job) : MultiCommodityFlow(job)
 {
-	PathVector paths;
 	uint16 size = job.Size();
 	uint accuracy = job.Settings().accuracy;
 	bool more_loops;
@@ -562,12 +878,8 @@ MCF1stPass::MCF1stPass(LinkGraphJob &job) : MultiCommodityFlow(job)
 
 	do {
 		more_loops = false;
-		for (NodeID source = 0; source < size; ++source) {
-			if (finished_sources[source]) continue;
-
-			/* First saturate the shortest paths. */
-			this->Dijkstra<DistanceAnnotation, GraphEdgeIterator>(source, paths);
-
+		/* First saturate the shortest paths. */
+		this->ForEachSource<DistanceAnnotation, GraphEdgeIterator>(finished_sources, [&](NodeID source, PathVector &paths) {
 			bool source_demand_left = false;
 			for (DemandAnnotation &anno : job[source].GetDemandAnnotations()) {
 				NodeID dest = anno.dest;
@@ -591,8 +903,13 @@ MCF1stPass::MCF1stPass(LinkGraphJob &job) : MultiCommodityFlow(job)
 			}
 			if (!source_demand_left) finished_sources[source] = true;
 			this->CleanupPaths(source, paths);
-		}
+		});
 	} while ((more_loops || this->EliminateCycles()) && !job.IsJobAborted());
+
+	if (this->speculation_hits + this->speculation_misses > 0) {
+		DEBUG(linkgraph, 2, "MCF1stPass: job: %u, nodes: %u, paths calculated in advance: used: %u, recalculated: %u",
+				job.LinkGraphIndex(), size, this->speculation_hits, this->speculation_misses);
+	}
 }
 
 /**
@@ -603,18 +920,13 @@ MCF1stPass::MCF1stPass(LinkGraphJob &job) : MultiCommodityFlow(job)
 MCF2ndPass::MCF2ndPass(LinkGraphJob &job) : MultiCommodityFlow(job)
 {
 	this->max_saturation = UINT_MAX; // disable artificial cap on saturation
-	PathVector paths;
 	uint16 size = job.Size();
 	uint accuracy = job.Settings().accuracy;
 	bool demand_left = true;
 	std::vector<bool> finished_sources(size);
 	while (demand_left && !job.IsJobAborted()) {
 		demand_left = false;
-		for (NodeID source = 0; source < size; ++source) {
-			if (finished_sources[source]) continue;
-
-			this->Dijkstra<CapacityAnnotation, FlowEdgeIterator>(source, paths);
-
+		this->ForEachSource<CapacityAnnotation, FlowEdgeIterator>(finished_sources, [&](NodeID source, PathVector &paths) {
 			bool source_demand_left = false;
 			for (DemandAnnotation &anno : this->job[source].GetDemandAnnotations()) {
 				if (anno.unsatisfied_demand == 0) continue;
@@ -629,7 +941,12 @@ MCF2ndPass::MCF2ndPass(LinkGraphJob &job) : MultiCommodityFlow(job)
 			}
 			if (!source_demand_left) finished_sources[source] = true;
 			this->CleanupPaths(source, paths);
-		}
+		});
+	}
+
+	if (this->speculation_hits + this->speculation_misses > 0) {
+		DEBUG(linkgraph, 2, "MCF2ndPass: job: %u, nodes: %u, paths calculated in advance: used: %u, recalculated: %u",
+				job.LinkGraphIndex(), size, this->speculation_hits, this->speculation_misses);
 	}
 }
 
@@ -677,3 +994,126 @@ bool DistanceAnnotation::Comparator::operator()(const AnnoSetItem<DistanceAnnota
 	return x.anno_ptr != y.anno_ptr && !Greater<uint>(x.cached_annotation, y.cached_annotation,
 			x.node_id, y.node_id);
 }
+
+/** Synthetic graph for benchmarking the Dijkstra priority queues. */
+struct MCFBenchmarkGraph {
+	struct BenchmarkEdge {
+		NodeID to;
+		uint capacity;
+		int free_capacity;
+		uint distance;
+	};
+
+	std::vector<std::vector<BenchmarkEdge>> edges; ///< Outgoing edges per node.
+	uint edge_count = 0;
+
+	/**
+	 * Generate a connected random graph.
+	 * @param node_count Number of nodes.
+	 * @param seed Random seed.
+	 */
+	MCFBenchmarkGraph(uint node_count, uint32 seed) : edges(node_count)
+	{
+		std::mt19937 rng(seed);
+		auto add_edge = [&](uint from, uint to) {
+			uint capacity = 1 + (uint)(rng() % 1000);
+			int free_capacity = (int)capacity - (int)(rng() % 1200);
+			uint distance = 1 + (uint)(rng() % 1000);
+			this->edges[from].push_back({ (NodeID)to, capacity, free_capacity, distance });
+			this->edge_count++;
+		};
+		for (uint node = 0; node < node_count; node++) {
+			/* A ring to keep the graph connected, and some random links. */
+			add_edge(node, (node + 1) % node_count);
+			for (uint i = 0; i < 4; i++) add_edge(node, rng() % node_count);
+		}
+	}
+};
+
+/**
+ * Run the Dijkstra algorithm as used by the first MCF pass on a synthetic graph.
+ * @tparam Tqueue Priority queue to use.
+ * @param graph Graph.
+ * @param source_node Source node.
+ * @param annos Storage for the annotations.
+ * @return Checksum of the resulting distances.
+ */
+template<class Tqueue>
+static uint64 BenchmarkDijkstra(const MCFBenchmarkGraph &graph, NodeID source_node, std::vector<DistanceAnnotation> &annos)
+{
+	const uint size = (uint)graph.edges.size();
+	annos.clear();
+	annos.reserve(size);
+	for (uint node = 0; node < size; node++) {
+		annos.emplace_back((NodeID)node, node == source_node);
+	}
+
+	Tqueue queue(size);
+	queue.Update(&annos[source_node]);
+	while (!queue.IsEmpty()) {
+		DistanceAnnotation *source = queue.Pop();
+		for (const MCFBenchmarkGraph::BenchmarkEdge &edge : graph.edges[source->GetNode()]) {
+			if (edge.to == source->GetNode()) continue;
+			DistanceAnnotation *dest = &annos[edge.to];
+			if (dest->IsBetter(source, edge.capacity, edge.free_capacity, edge.distance)) {
+				queue.PrepareUpdate(dest);
+				dest->Fork(source, edge.capacity, edge.free_capacity, edge.distance);
+				dest->UpdateAnnotation();
+				queue.Update(dest);
+			}
+		}
+	}
+
+	uint64 checksum = 0;
+	for (const DistanceAnnotation &anno : annos) {
+		checksum = (checksum * 31) + anno.GetDistance();
+	}
+	return checksum;
+}
+
+/**
+ * Time running the Dijkstra algorithm from a number of source nodes on a synthetic graph.
+ * @tparam Tqueue Priority queue to use.
+ * @param graph Graph.
+ * @param sources Number of source nodes.
+ * @param annos Storage for the annotations.
+ * @param[out] checksum Checksum of all resulting distances.
+ * @return Run time in microseconds.
+ */
+template<class Tqueue>
+static uint64 TimeBenchmarkDijkstra(const MCFBenchmarkGraph &graph, uint sources, std::vector<DistanceAnnotation> &annos, uint64 &checksum)
+{
+	const uint size = (uint)graph.edges.size();
+	checksum = 0;
+	const auto start = std::chrono::steady_clock::now();
+	for (uint i = 0; i < sources; i++) {
+		checksum += BenchmarkDijkstra<Tqueue>(graph, (NodeID)((i * 7919) % size), annos);
+	}
+	return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * Benchmark the MCF Dijkstra priority queues on a synthetic graph.
+ * @param b Buffer to write the result to.
+ * @param last Last valid byte of the buffer.
+ * @param node_count Number of nodes of the synthetic graph.
+ * @return Updated buffer position.
+ */
+char *BenchmarkMCFDijkstraQueues(char *b, const char *last, uint node_count)
+{
+	node_count = Clamp<uint>(node_count, 2, INVALID_NODE - 1);
+	const MCFBenchmarkGraph graph(node_count, 0x4D4346);
+	const uint sources = Clamp<uint>(2000000 / node_count, 4, 256);
+	std::vector<DistanceAnnotation> annos;
+
+	uint64 set_checksum;
+	uint64 heap_checksum;
+	const uint64 set_us = TimeBenchmarkDijkstra<AnnoSetQueue<DistanceAnnotation>>(graph, sources, annos, set_checksum);
+	const uint64 heap_us = TimeBenchmarkDijkstra<AnnoHeapQueue<DistanceAnnotation>>(graph, sources, annos, heap_checksum);
+
+	b += seprintf(b, last, "Nodes: %u, edges: %u, sources: %u\n", node_count, graph.edge_count, sources);
+	b += seprintf(b, last, "  btree_set:  " OTTD_PRINTF64U " us, " OTTD_PRINTF64U " us per source\n", set_us, set_us / sources);
+	b += seprintf(b, last, "  4-ary heap: " OTTD_PRINTF64U " us, " OTTD_PRINTF64U " us per source\n", heap_us, heap_us / sources);
+	if (set_checksum != heap_checksum) b += seprintf(b, last, "  Results differ!\n");
+	return b;
+}
@@ -21,8 +21,36 @@ protected:
 			max_saturation(job.Settings().short_path_saturation)
 	{}
 
-	template<class Tannotation, class Tedge_iterator>
-	void Dijkstra(NodeID from, PathVector &paths);
+	/** Paths calculated by Dijkstra for an upcoming source node in advance, see ForEachSource. */
+	struct SpeculativePaths {
+		DynUniformArenaAllocator allocator; ///< Allocator for the paths, separate from the job's path allocator.
+		PathVector paths;                   ///< Paths calculated by Dijkstra.
+		std::vector<uint> edges_read;       ///< Indices of the edges read by Dijkstra.
+	};
+
+	/** Edge and the state of it which the result of Dijkstra depends on, see PushFlow. */
+	struct EdgeState {
+		Edge *edge;
+		uint state;
+	};
+
+	typedef uint EdgeStateProc(const Edge &edge, uint capacity);
+
+	static const uint MIN_SPECULATIVE_SIZE = 32;  ///< Minimum number of nodes of a job to calculate paths of sources in advance.
+	static const uint MAX_SPECULATIVE_BATCH = 16; ///< Maximum number of sources to calculate paths for in advance at once.
+
+	template<class Tannotation, class Tedge_iterator, class Tqueue>
+	void Dijkstra(NodeID from, PathVector &paths, DynUniformArenaAllocator &allocator, std::vector<uint> *edges_read);
+
+	template<class Tannotation, class Tedge_iterator, class Tprocess>
+	void ForEachSource(const std::vector<bool> &finished_sources, Tprocess process_source);
+
+	template<class Tannotation>
+	void MoveSpeculativePaths(SpeculativePaths &speculative, PathVector &paths);
+
+	bool IsSpeculationValid(const SpeculativePaths &speculative) const;
+
+	uint GetUsableCapacity(const Edge &edge) const;
 
 	uint PushFlow(DemandAnnotation &anno, Path *path, uint min_step_size, uint accuracy, uint max_saturation);
 
@@ -30,6 +58,13 @@ protected:
 
 	LinkGraphJob &job;   ///< Job we're working with.
 	uint max_saturation; ///< Maximum saturation for edges.
+
+	EdgeStateProc *edge_state_proc = nullptr; ///< Edge state function of the current annotation if edge changes are tracked, otherwise nullptr.
+	std::vector<uint> edge_changed;           ///< Per edge, ID of the last batch in which its state changed.
+	uint batch_id = 0;                        ///< ID of the current batch of sources.
+	std::vector<EdgeState> pushed_edges;      ///< Edges of the path flow is currently being pushed along.
+	uint speculation_hits = 0;                ///< Number of sources for which the paths calculated in advance were used.
+	uint speculation_misses = 0;              ///< Number of sources for which the paths had to be calculated again.
 };
 
 /**
@@ -14,10 +14,16 @@
 #include "string_func.h"
 #include "rail_map.h"
 #include "tunnelbridge_map.h"
+#include "rail_state_region.h"
+#include "pathfinder/yapf/yapf_cache.h"
 #include "3rdparty/cpp-btree/btree_map.h"
 #include <array>
 #include <deque>
 
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
 #include "safeguards.h"
 
 #if defined(_MSC_VER)
@@ -34,6 +40,11 @@ uint _map_tile_mask; ///< _map_size - 1 (to mask the mapsize)
 
 Tile *_m = nullptr;          ///< Tiles of the map
 TileExtended *_me = nullptr; ///< Extended Tiles of the map
+#ifdef WITH_SPLIT_MAP_ARRAYS
+byte *_m_type = nullptr;     ///< Types of the tiles of the map
+byte *_m_height = nullptr;   ///< Heights of the tiles of the map
+#endif
+uint32 *_rail_state_region_versions = nullptr; ///< Versions of the rail reservation and signal state of the map regions, see NotifyRailStateChange
 
 /**
  * Validates whether a map with the given dimension is valid
@@ -55,6 +66,33 @@ bool ValidateMapSize(uint size_x, uint size_y)
 	return true;
 }
 
+/**
+ * Allocate a zero filled array for data of each tile of the map.
+ * On Linux arrays of at least huge page size are aligned to it, and transparent huge pages are requested
+ * for them: the map arrays are large and accessed all over, so this saves many TLB misses.
+ * The arrays are not padded, the partial huge page at the end is left to the kernel.
+ * @param count Number of tiles.
+ * @return The array, to be freed with free().
+ */
+template <typename T>
+static T *AllocateMapArray(size_t count)
+{
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+	static const size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+	const size_t size = count * sizeof(T);
+	if (size < HUGE_PAGE_SIZE) return CallocT<T>(count);
+
+	void *ptr;
+	if (posix_memalign(&ptr, HUGE_PAGE_SIZE, size) != 0) MallocError(size);
+	madvise(ptr, size, MADV_HUGEPAGE);
+	memset(ptr, 0, size);
+	return static_cast<T *>(ptr);
+#else
+	return CallocT<T>(count);
+#endif
+}
+
 /**
  * (Re)allocates a map with the given dimension
  * @param size_x the width of the map along the NE/SW edge
@@ -78,9 +116,22 @@ void AllocateMap(uint size_x, uint size_y)
 
 	free(_m);
 	free(_me);
+#ifdef WITH_SPLIT_MAP_ARRAYS
+	free(_m_type);
+	free(_m_height);
+#endif
+
+	_m = AllocateMapArray<Tile>(_map_size);
+	_me = AllocateMapArray<TileExtended>(_map_size);
+#ifdef WITH_SPLIT_MAP_ARRAYS
+	_m_type = AllocateMapArray<byte>(_map_size);
+	_m_height = AllocateMapArray<byte>(_map_size);
+#endif
 
-	_m = CallocT<Tile>(_map_size);
-	_me = CallocT<TileExtended>(_map_size);
+	/* The rail state regions are sized from the map size, the routes cached for the old map are all invalid */
+	free(_rail_state_region_versions);
+	_rail_state_region_versions = CallocT<uint32>(GetRailStateRegionCount());
+	YapfFlushRailRouteCache();
 }
 
 
@@ -511,7 +562,7 @@ char *DumpTileInfo(char *b, const char *last, TileIndex tile)
 			b += seprintf(b, last, ", TILE OUTSIDE MAP");
 		} else {
 			b += seprintf(b, last, ", type: %02X (%s), height: %02X, data: %02X %04X %02X %02X %02X %02X %02X %04X",
-					_m[tile].type, tile_type_names[GB(_m[tile].type, 4, 4)], _m[tile].height,
+					TileTypeByte(tile), tile_type_names[GB(TileTypeByte(tile), 4, 4)], TileHeightByte(tile),
 					_m[tile].m1, _m[tile].m2, _m[tile].m3, _m[tile].m4, _m[tile].m5, _me[tile].m6, _me[tile].m7, _me[tile].m8);
 		}
 	}
@@ -41,6 +41,53 @@ extern Tile *_m;
  */
 extern TileExtended *_me;
 
+#ifdef WITH_SPLIT_MAP_ARRAYS
+/**
+ * Pointer to the tile type array, only with the alternative map layout.
+ *
+ * The type (bits 4..7), bridges (2..3) and rainforest/desert (0..1) byte of
+ * each tile. It is kept out of Tile, so that the many scans which only look
+ * at the tile types touch a dense array.
+ */
+extern byte *_m_type;
+
+/**
+ * Pointer to the tile height array, only with the alternative map layout.
+ *
+ * The height of the northern corner of each tile. It is kept out of Tile for
+ * the same reason as _m_type.
+ */
+extern byte *_m_height;
+#endif
+
+/**
+ * Get the type, bridges and rainforest/desert byte of a tile, wherever the map layout stores it.
+ * @param t the tile
+ * @return reference to the byte
+ */
+debug_inline static byte &TileTypeByte(TileIndex t)
+{
+#ifdef WITH_SPLIT_MAP_ARRAYS
+	return _m_type[t];
+#else
+	return _m[t].type;
+#endif
+}
+
+/**
+ * Get the height byte of a tile, wherever the map layout stores it.
+ * @param t the tile
+ * @return reference to the byte
+ */
+debug_inline static byte &TileHeightByte(TileIndex t)
+{
+#ifdef WITH_SPLIT_MAP_ARRAYS
+	return _m_height[t];
+#else
+	return _m[t].height;
+#endif
+}
+
 bool ValidateMapSize(uint size_x, uint size_y);
 void AllocateMap(uint size_x, uint size_y);
 
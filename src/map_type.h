@@ -12,11 +12,14 @@
 
 /**
  * Data that is stored per tile. Also used TileExtended for this.
+ * With the alternative map layout (WITH_SPLIT_MAP_ARRAYS) the type and height are stored in _m_type and _m_height instead.
  * Look at docs/landscape.html for the exact meaning of the members.
  */
 struct Tile {
+#ifndef WITH_SPLIT_MAP_ARRAYS
 	byte   type;        ///< The type (bits 4..7), bridges (2..3), rainforest/desert (0..1)
 	byte   height;      ///< The height of the northern corner.
+#endif
 	uint16 m2;          ///< Primarily used for indices to towns, industries and stations
 	byte   m1;          ///< Primarily used for ownership information
 	byte   m3;          ///< General purpose
@@ -24,7 +27,11 @@ struct Tile {
 	byte   m5;          ///< General purpose
 };
 
+#ifdef WITH_SPLIT_MAP_ARRAYS
+static_assert(sizeof(Tile) == 6);
+#else
 static_assert(sizeof(Tile) == 8);
+#endif
 
 /**
  * Data that is stored per tile. Also used Tile for this.
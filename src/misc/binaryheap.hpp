@@ -5,14 +5,14 @@
  * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
  */
 
-/** @file binaryheap.hpp Binary heap implementation. */
+/** @file binaryheap.hpp Binary and d-ary heap implementation. */
 
 #ifndef BINARYHEAP_HPP
 #define BINARYHEAP_HPP
 
 #include "../core/alloc_func.hpp"
 
-/** Enable it if you suspect binary heap doesn't work well */
+/** Enable it if you suspect heap doesn't work well */
 #define BINARYHEAP_CHECK 0
 
 #if BINARYHEAP_CHECK
@@ -24,17 +24,18 @@
 #endif
 
 /**
- * Binary Heap as C++ template.
+ * D-ary Heap as C++ template.
  *  A carrier which keeps its items automatically holds the smallest item at
- *  the first position. The order of items is maintained by using a binary tree.
+ *  the first position. The order of items is maintained by using a tree
+ *  in which each node has up to Tarity_ children.
  *  The implementation is used for priority queue's.
  *
  * @par Usage information:
- * Item of the binary heap should support the 'lower-than' operator '<'.
+ * Item of the heap should support the 'lower-than' operator '<'.
  * It is used for comparing items before moving them to their position.
  *
  * @par
- * This binary heap allocates just the space for item pointers. The items
+ * This heap allocates just the space for item pointers. The items
  * are allocated elsewhere.
  *
  * @par Implementation notes:
@@ -42,31 +43,43 @@
  * implementation.
  *
  * @par
+ * With 1-based indexing the children of the item at position i are at
+ * [Tarity_ * (i - 1) + 2, Tarity_ * i + 1], its parent is at (i - 2) / Tarity_ + 1.
+ * For Tarity_ == 2 this is the well known binary heap (children at 2i and 2i + 1).
+ * A wider tree is shallower, which makes Include cheaper and Shift compare
+ * more children per level but touch fewer cache lines in total.
+ *
+ * @par
  * For further information about the Binary Heap algorithm, see
  * http://www.policyalmanac.org/games/binaryHeaps.htm
  *
- * @tparam T Type of the items stored in the binary heap
+ * @tparam T Type of the items stored in the heap
+ * @tparam Tarity_ Number of children of each node of the tree
  */
-template <class T>
-class CBinaryHeapT {
+template <class T, uint Tarity_>
+class CDaryHeapT {
+	static_assert(Tarity_ >= 2);
+
 private:
 	uint items;    ///< Number of items in the heap
 	uint capacity; ///< Maximum number of items the heap can hold
 	T **data;      ///< The pointer to the heap item pointers
 
 public:
+	static const uint ARITY = Tarity_; ///< Number of children of each node of the tree
+
 	/**
-	 * Create a binary heap.
-	 * @param max_items The limit of the heap
+	 * Create a heap.
+	 * @param max_items The initial limit of the heap, it grows when needed
 	 */
-	explicit CBinaryHeapT(uint max_items)
+	explicit CDaryHeapT(uint max_items)
 		: items(0)
 		, capacity(max_items)
 	{
 		this->data = MallocT<T *>(max_items + 1);
 	}
 
-	~CBinaryHeapT()
+	~CDaryHeapT()
 	{
 		this->Clear();
 		free(this->data);
@@ -74,9 +87,29 @@ public:
 	}
 
 protected:
+	/**
+	 * Get the position of the first child of an item.
+	 * @param index The position of the item
+	 * @return The position of its first child
+	 */
+	static inline uint FirstChild(uint index)
+	{
+		return Tarity_ * (index - 1) + 2;
+	}
+
+	/**
+	 * Get the position of the parent of an item.
+	 * @param index The position of the item, not the first one
+	 * @return The position of its parent
+	 */
+	static inline uint Parent(uint index)
+	{
+		return (index - 2) / Tarity_ + 1;
+	}
+
 	/**
 	 * Get position for fixing a gap (downwards).
-	 *  The gap is moved downwards in the binary tree until it
+	 *  The gap is moved downwards in the tree until it
 	 *  is in order again.
 	 *
 	 * @param gap The position of the gap
@@ -87,14 +120,14 @@ protected:
 	{
 		assert(gap != 0);
 
-		/* The first child of the gap is at [parent * 2] */
-		uint child = gap * 2;
+		uint child = FirstChild(gap);
 
 		/* while children are valid */
 		while (child <= this->items) {
-			/* choose the smaller child */
-			if (child < this->items && *this->data[child + 1] < *this->data[child]) {
-				child++;
+			/* choose the smallest child, the first one wins ties */
+			const uint last_child = std::min(child + Tarity_ - 1, this->items);
+			for (uint sibling = child + 1; sibling <= last_child; sibling++) {
+				if (*this->data[sibling] < *this->data[child]) child = sibling;
 			}
 			/* is it smaller than our parent? */
 			if (!(*this->data[child] < *item)) {
@@ -105,14 +138,14 @@ protected:
 			this->data[gap] = this->data[child];
 			gap = child;
 			/* where do we have our new children? */
-			child = gap * 2;
+			child = FirstChild(gap);
 		}
 		return gap;
 	}
 
 	/**
 	 * Get position for fixing a gap (upwards).
-	 *  The gap is moved upwards in the binary tree until the
+	 *  The gap is moved upwards in the tree until the
 	 *  is in order again.
 	 *
 	 * @param gap The position of the gap
@@ -127,7 +160,7 @@ protected:
 
 		while (gap > 1) {
 			/* compare [gap] with its parent */
-			parent = gap / 2;
+			parent = Parent(gap);
 			if (!(*item < *this->data[parent])) {
 				/* we don't need to continue upstairs */
 				break;
@@ -143,7 +176,7 @@ protected:
 	inline void CheckConsistency()
 	{
 		for (uint child = 2; child <= this->items; child++) {
-			uint parent = child / 2;
+			uint parent = Parent(child);
 			assert(!(*this->data[child] < *this->data[parent]));
 		}
 	}
@@ -181,7 +214,7 @@ public:
 	}
 
 	/**
-	 * Get the smallest item in the binary tree.
+	 * Get the smallest item in the tree.
 	 *
 	 * @return The smallest item, or throw assert if empty.
 	 */
@@ -192,7 +225,7 @@ public:
 	}
 
 	/**
-	 * Get the LAST item in the binary tree.
+	 * Get the LAST item in the tree.
 	 *
 	 * @note The last item is not necessary the biggest!
 	 *
@@ -259,7 +292,7 @@ public:
 			/* at position index we have a gap now */
 
 			T *last = this->End();
-			/* Fix binary tree up and downwards */
+			/* Fix the tree up and downwards */
 			uint gap = this->HeapifyUp(index, last);
 			gap = this->HeapifyDown(gap, last);
 			/* move last item to the proper place */
@@ -300,4 +333,12 @@ public:
 	}
 };
 
+/** Binary heap, see CDaryHeapT. */
+template <class T>
+using CBinaryHeapT = CDaryHeapT<T, 2>;
+
+/** 4-ary heap, see CDaryHeapT. */
+template <class T>
+using CQuaternaryHeapT = CDaryHeapT<T, 4>;
+
 #endif /* BINARYHEAP_HPP */
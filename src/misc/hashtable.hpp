@@ -11,6 +11,7 @@
 #define HASHTABLE_HPP
 
 #include "../core/math_func.hpp"
+#include <vector>
 
 template <class Titem_>
 struct CHashTableSlotT
@@ -183,6 +184,7 @@ public:
 	inline void Clear()
 	{
 		for (int i = 0; i < Tcapacity; i++) m_slots[i].Clear();
+		m_num_items = 0;
 	}
 
 	/** const item search */
@@ -254,4 +256,145 @@ public:
 	}
 };
 
+/**
+ * class CResettableHashTableT<Titem> - hash table of pointers allocated
+ *  elsewhere, like CHashTableT, but with the number of slots chosen at
+ *  run time and an O(1) Reset().
+ *
+ *  Each slot is tagged with the generation in which it was last written,
+ *  slots tagged with an older generation read as empty. Reset() therefore
+ *  only has to advance the generation, unless the table is resized or the
+ *  generation counter wraps.
+ *
+ *  The requirements on Titem are the same as for CHashTableT.
+ */
+template <class Titem_>
+class CResettableHashTableT {
+public:
+	typedef Titem_ Titem;                         // make Titem_ visible from outside of class
+	typedef typename Titem_::Key Tkey;            // make Titem_::Key a property of HashTable
+
+protected:
+	typedef CHashTableSlotT<Titem_> Slot;
+
+	/** slot with the generation in which it was last written */
+	struct TaggedSlot {
+		Slot   slot;
+		uint32 generation = 0;
+	};
+
+	std::vector<TaggedSlot> m_slots; // here we store our data, the size is always a power of two
+	uint32 m_mask = 0;               // number of slots - 1
+	uint32 m_generation = 1;         // current generation, slots of other generations are empty
+	int    m_num_items = 0;          // item counter
+
+	/** helper - return hash for the given key modulo number of slots, the same hash as CHashTableT */
+	inline uint32 CalcHash(const Tkey &key) const
+	{
+		uint32 hash = key.CalcHash();
+		hash -= (hash >> 17);          // hash * 131071 / 131072
+		hash -= (hash >> 5);           //   * 31 / 32
+		return hash & m_mask;          //   modulo slots
+	}
+
+	/** helper - return the slot of the given key, forgetting its items if they are from an older generation */
+	inline Slot &GetSlot(const Tkey &key)
+	{
+		TaggedSlot &tagged = m_slots[CalcHash(key)];
+		if (tagged.generation != m_generation) {
+			tagged.slot.Clear();
+			tagged.generation = m_generation;
+		}
+		return tagged.slot;
+	}
+
+public:
+	/**
+	 * Construct the table.
+	 * @param hash_bits Initial number of slots as power of two.
+	 */
+	explicit CResettableHashTableT(uint hash_bits)
+	{
+		this->Reset(hash_bits);
+	}
+
+	/** item count */
+	inline int Count() const
+	{
+		return m_num_items;
+	}
+
+	/**
+	 * Forget all items.
+	 * @param hash_bits New number of slots as power of two.
+	 */
+	void Reset(uint hash_bits)
+	{
+		const uint32 capacity = 1 << hash_bits;
+		if (m_slots.size() != capacity) {
+			/* reallocate, this implicitly clears all slots */
+			m_slots.clear();
+			m_slots.resize(capacity);
+			m_slots.shrink_to_fit();
+			m_mask = capacity - 1;
+			m_generation = 1;
+		} else if (++m_generation == 0) {
+			/* the generation wrapped, older tags could become valid again */
+			for (TaggedSlot &tagged : m_slots) tagged.generation = 0;
+			m_generation = 1;
+		}
+		m_num_items = 0;
+	}
+
+	/** non-const item search */
+	Titem_ *Find(const Tkey &key)
+	{
+		return GetSlot(key).Find(key);
+	}
+
+	/** non-const item search & optional removal (if found) */
+	Titem_ *TryPop(const Tkey &key)
+	{
+		Titem_ *item = GetSlot(key).Detach(key);
+		if (item != nullptr) {
+			m_num_items--;
+		}
+		return item;
+	}
+
+	/** non-const item search & removal */
+	Titem_& Pop(const Tkey &key)
+	{
+		Titem_ *item = TryPop(key);
+		assert(item != nullptr);
+		return *item;
+	}
+
+	/** non-const item search & optional removal (if found) */
+	bool TryPop(Titem_ &item)
+	{
+		bool ret = GetSlot(item.GetKey()).Detach(item);
+		if (ret) {
+			m_num_items--;
+		}
+		return ret;
+	}
+
+	/** non-const item search & removal */
+	void Pop(Titem_ &item)
+	{
+		[[maybe_unused]] bool ret = TryPop(item);
+		assert(ret);
+	}
+
+	/** add one item - copy it from the given item */
+	void Push(Titem_ &new_item)
+	{
+		Slot &slot = GetSlot(new_item.GetKey());
+		assert(slot.Find(new_item.GetKey()) == nullptr);
+		slot.Attach(new_item);
+		m_num_items++;
+	}
+};
+
 #endif /* HASHTABLE_HPP */
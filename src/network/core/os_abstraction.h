@@ -115,6 +115,18 @@ typedef unsigned long in_addr_t;
 #	include <sys/time.h>
 #	include <netdb.h>
 
+#	if !defined(__EMSCRIPTEN__)
+/* Send multiple queued packets with a single system call. */
+#		include <sys/uio.h>
+#		define HAVE_WRITEV
+#	endif
+
+/* Use epoll instead of select for the listening sockets and their connections, this is not limited to FD_SETSIZE sockets. */
+#	if defined(__linux__) && !defined(__EMSCRIPTEN__)
+#		include <sys/epoll.h>
+#		define HAVE_EPOLL
+#	endif
+
 #   if defined(__EMSCRIPTEN__)
 /* Emscripten doesn't support AI_ADDRCONFIG and errors out on it. */
 #		undef AI_ADDRCONFIG
@@ -89,6 +89,16 @@ public:
 
 	size_t RemainingBytesToTransfer() const;
 
+	/**
+	 * Mark bytes as transferred, after they were transferred out of the packet by other means than #TransferOut.
+	 * @param bytes The number of bytes, at most #RemainingBytesToTransfer.
+	 */
+	void AdvanceTransferPosition(size_t bytes)
+	{
+		assert(bytes <= this->RemainingBytesToTransfer());
+		this->pos += (PacketSize)bytes;
+	}
+
 	const byte *GetBufferData() const { return this->buffer.data(); }
 	PacketSize GetRawPos() const { return this->pos; }
 	void ReserveBuffer(size_t size) { this->buffer.reserve(size); }
@@ -16,13 +16,18 @@
 
 #include "../../safeguards.h"
 
+#ifdef HAVE_WRITEV
+/** Maximum number of queued packets passed to a single writev call. */
+static const int SEND_PACKETS_BATCH_SIZE = 32;
+#endif
+
 /**
  * Construct a socket handler for a TCP connection.
  * @param s The just opened TCP connection.
  */
 NetworkTCPSocketHandler::NetworkTCPSocketHandler(SOCKET s) :
 		NetworkSocketHandler(),
-		sock(s), writable(false)
+		sock(s), writable(false), readable(false), poll_registered(false)
 {
 }
 
@@ -62,6 +67,7 @@ NetworkRecvStatus NetworkTCPSocketHandler::CloseConnection(bool error)
 {
 	this->MarkClosed();
 	this->writable = false;
+	this->readable = false;
 
 	this->EmptyPacketQueue();
 
@@ -115,7 +121,8 @@ void NetworkTCPSocketHandler::SendPrependPacket(std::unique_ptr<Packet> packet,
 }
 
 /**
- * Sends all the buffered packets out for this client. It stops when:
+ * Sends all the buffered packets out for this client, where possible
+ * several packets with a single system call. It stops when:
  *   1) all packets are send (queue is empty)
  *   2) the OS reports back that it can not send any more
  *      data right now (full network-buffer, it happens ;))
@@ -133,8 +140,23 @@ SendPacketsState NetworkTCPSocketHandler::SendPackets(bool closing_down)
 	if (!this->IsConnected()) return SPS_CLOSED;
 
 	while (!this->packet_queue.empty()) {
+#ifdef HAVE_WRITEV
+		/* Send as many queued packets as possible at once. */
+		struct iovec iov[SEND_PACKETS_BATCH_SIZE];
+		int count = 0;
+		size_t offered = 0;
+		for (auto &p : this->packet_queue) {
+			if (count == SEND_PACKETS_BATCH_SIZE) break;
+			iov[count].iov_base = const_cast<byte *>(p->GetBufferData() + p->GetRawPos());
+			iov[count].iov_len = p->RemainingBytesToTransfer();
+			offered += iov[count].iov_len;
+			count++;
+		}
+		res = writev(this->sock, iov, count);
+#else
 		Packet *p = this->packet_queue.front().get();
 		res = p->TransferOut<int>(send, this->sock, 0);
+#endif
 		if (res == -1) {
 			NetworkError err = NetworkError::GetLast();
 			if (!err.WouldBlock()) {
@@ -145,6 +167,7 @@ SendPacketsState NetworkTCPSocketHandler::SendPackets(bool closing_down)
 				}
 				return SPS_CLOSED;
 			}
+			this->writable = false;
 			return SPS_PARTLY_SENT;
 		}
 		if (res == 0) {
@@ -153,6 +176,20 @@ SendPacketsState NetworkTCPSocketHandler::SendPackets(bool closing_down)
 			return SPS_CLOSED;
 		}
 
+#ifdef HAVE_WRITEV
+		/* Go to the next packets, the last one may only be partially sent. */
+		for (size_t sent = res; sent > 0;) {
+			Packet *p = this->packet_queue.front().get();
+			size_t len = std::min(sent, p->RemainingBytesToTransfer());
+			p->AdvanceTransferPosition(len);
+			sent -= len;
+			if (p->RemainingBytesToTransfer() == 0) {
+				if (_debug_net_level >= 5) this->LogSentPacket(*p);
+				this->packet_queue.pop_front();
+			}
+		}
+		if ((size_t)res < offered) return SPS_PARTLY_SENT;
+#else
 		/* Is this packet sent? */
 		if (p->RemainingBytesToTransfer() == 0) {
 			/* Go to the next packet */
@@ -161,6 +198,7 @@ SendPacketsState NetworkTCPSocketHandler::SendPackets(bool closing_down)
 		} else {
 			return SPS_PARTLY_SENT;
 		}
+#endif
 	}
 
 	return SPS_ALL_SENT;
@@ -195,6 +233,7 @@ std::unique_ptr<Packet> NetworkTCPSocketHandler::ReceivePacket()
 					return nullptr;
 				}
 				/* Connection would block, so stop for now */
+				this->readable = false;
 				return nullptr;
 			}
 			if (res == 0) {
@@ -224,6 +263,7 @@ std::unique_ptr<Packet> NetworkTCPSocketHandler::ReceivePacket()
 				return nullptr;
 			}
 			/* Connection would block */
+			this->readable = false;
 			return nullptr;
 		}
 		if (res == 0) {
@@ -44,6 +44,8 @@ private:
 public:
 	SOCKET sock;              ///< The socket currently connected to
 	bool writable;            ///< Can we write to this socket?
+	bool readable;            ///< May there be something to read from this socket? Only cleared once a read would block.
+	bool poll_registered;     ///< Whether the socket has been registered with the epoll instance of its listen handler.
 
 	/**
 	 * Whether this socket is currently bound to a socket.
@@ -75,6 +77,12 @@ public:
 	 */
 	bool HasSendQueue() { return !this->packet_queue.empty(); }
 
+	/**
+	 * Get the number of packets pending in the send queue.
+	 * @return Number of packets, including a partially sent packet.
+	 */
+	size_t GetSendQueueSize() const { return this->packet_queue.size(); }
+
 	NetworkTCPSocketHandler(SOCKET s = INVALID_SOCKET);
 	~NetworkTCPSocketHandler();
 };
@@ -29,6 +29,99 @@ class TCPListenHandler {
 	/** List of sockets we listen on. */
 	static SocketList sockets;
 
+#ifdef HAVE_EPOLL
+	/** Tag of the epoll events of the listening sockets, the socket itself is in the lower 32 bits. */
+	static const uint64 EPOLL_LISTENER_TAG = 1ULL << 32;
+	/** Maximum number of events handled per call to epoll_wait. */
+	static const int EPOLL_MAX_EVENTS = 64;
+
+	/** Epoll instance of the listening and connected sockets, or -1 when using select. */
+	static int epoll_fd;
+
+	/**
+	 * Create the epoll instance and register the listening sockets with it.
+	 * On failure select is used instead.
+	 */
+	static void InitEpoll()
+	{
+		epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+		if (epoll_fd == -1) {
+			DEBUG(net, 1, "[%s] epoll_create1 failed, using select: %s", Tsocket::GetName(), NetworkError::GetLast().AsString());
+			return;
+		}
+
+		for (auto &s : sockets) {
+			struct epoll_event ev = {};
+			ev.events = EPOLLIN;
+			ev.data.u64 = EPOLL_LISTENER_TAG | (uint32)s.first;
+			if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, s.first, &ev) != 0) {
+				DEBUG(net, 1, "[%s] epoll_ctl failed, using select: %s", Tsocket::GetName(), NetworkError::GetLast().AsString());
+				close(epoll_fd);
+				epoll_fd = -1;
+				return;
+			}
+		}
+		DEBUG(net, 5, "[%s] Using epoll", Tsocket::GetName());
+	}
+
+	/**
+	 * Handle the receiving of packets using edge-triggered epoll notifications.
+	 * A socket stays #NetworkTCPSocketHandler::readable or #NetworkTCPSocketHandler::writable until
+	 * reading or writing would block, so only the sockets which changed state are reported by the kernel.
+	 * @return true if everything went okay.
+	 */
+	static bool ReceiveEpoll()
+	{
+		struct epoll_event events[EPOLL_MAX_EVENTS];
+		for (;;) {
+			int count = epoll_wait(epoll_fd, events, EPOLL_MAX_EVENTS, 0); // don't block at all.
+			if (count < 0) {
+				if (errno == EINTR) continue;
+				return false;
+			}
+
+			for (int i = 0; i < count; i++) {
+				const uint64 data = events[i].data.u64;
+				if (data & EPOLL_LISTENER_TAG) {
+					/* accept clients.. */
+					AcceptClient((SOCKET)(uint32)data);
+					continue;
+				}
+
+				/* The socket may have been closed in the mean time, and its pool index reused: a spurious readiness flag is harmless. */
+				Tsocket *cs = Tsocket::GetIfValid((size_t)data);
+				if (cs == nullptr) continue;
+				if (events[i].events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)) cs->readable = true;
+				if (events[i].events & (EPOLLOUT | EPOLLHUP | EPOLLERR)) cs->writable = true;
+			}
+			if (count < EPOLL_MAX_EVENTS) break;
+		}
+
+		/* register new connections, these may already be readable and writable. */
+		for (Tsocket *cs : Tsocket::Iterate()) {
+			if (cs->poll_registered || cs->sock == INVALID_SOCKET) continue;
+
+			struct epoll_event ev = {};
+			ev.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+			ev.data.u64 = cs->index;
+			if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, cs->sock, &ev) == 0) {
+				cs->poll_registered = true;
+			} else {
+				DEBUG(net, 1, "[%s] epoll_ctl failed: %s", Tsocket::GetName(), NetworkError::GetLast().AsString());
+			}
+			/* Unregistered sockets are just tried every time. */
+			cs->readable = true;
+			cs->writable = true;
+		}
+
+		/* read stuff from clients */
+		for (Tsocket *cs : Tsocket::Iterate()) {
+			if (cs->readable) cs->ReceivePackets();
+		}
+		return _networking;
+	}
+#endif /* HAVE_EPOLL */
+
 public:
 	static bool ValidateClient(SOCKET s, NetworkAddress &address)
 	{
@@ -100,6 +193,10 @@ public:
 	 */
 	static bool Receive()
 	{
+#ifdef HAVE_EPOLL
+		if (epoll_fd != -1) return ReceiveEpoll();
+#endif
+
 		fd_set read_fd, write_fd;
 		struct timeval tv;
 
@@ -128,7 +225,8 @@ public:
 		/* read stuff from clients */
 		for (Tsocket *cs : Tsocket::Iterate()) {
 			cs->writable = !!FD_ISSET(cs->sock, &write_fd);
-			if (FD_ISSET(cs->sock, &read_fd)) {
+			cs->readable = !!FD_ISSET(cs->sock, &read_fd);
+			if (cs->readable) {
 				cs->ReceivePackets();
 			}
 		}
@@ -157,6 +255,10 @@ public:
 			return false;
 		}
 
+#ifdef HAVE_EPOLL
+		InitEpoll();
+#endif
+
 		return true;
 	}
 
@@ -167,10 +269,19 @@ public:
 			closesocket(s.first);
 		}
 		sockets.clear();
+#ifdef HAVE_EPOLL
+		if (epoll_fd != -1) {
+			close(epoll_fd);
+			epoll_fd = -1;
+		}
+#endif
 		DEBUG(net, 5, "[%s] Closed listeners", Tsocket::GetName());
 	}
 };
 
 template <class Tsocket, PacketType Tfull_packet, PacketType Tban_packet> SocketList TCPListenHandler<Tsocket, Tfull_packet, Tban_packet>::sockets;
+#ifdef HAVE_EPOLL
+template <class Tsocket, PacketType Tfull_packet, PacketType Tban_packet> int TCPListenHandler<Tsocket, Tfull_packet, Tban_packet>::epoll_fd = -1;
+#endif
 
 #endif /* NETWORK_CORE_TCP_LISTEN_H */
@@ -972,7 +972,7 @@ bool NetworkServerStart()
 	_network_own_client_id = CLIENT_ID_SERVER;
 
 	_network_server_sync_records.reset(new std::array<NetworkSyncRecord, 1024>());
-	_network_server_sync_records->fill({ 0, 0, 0 });
+	_network_server_sync_records->fill({});
 	_network_server_sync_records_next = 0;
 
 	_network_clients_connected = 0;
@@ -1114,6 +1114,22 @@ void NetworkBackgroundLoop()
 	NetworkBackgroundUDPLoop();
 }
 
+/**
+ * Get the sync record of the frame which has just been run.
+ * @return The record.
+ */
+NetworkSyncRecord GetCurrentNetworkSyncRecord()
+{
+	NetworkSyncRecord record;
+	record.frame = _frame_counter;
+	record.seed_1 = _random.state[0];
+	record.state_checksum = _state_checksum.state;
+	for (uint i = 0; i < SCS_END; i++) {
+		record.subsystem_state_checksums[i] = _subsystem_state_checksums[i].state;
+	}
+	return record;
+}
+
 /* The main loop called from ttd.c
  *  Here we also have to do StateGameLoop if needed! */
 void NetworkGameLoop()
@@ -1269,7 +1285,7 @@ void NetworkGameLoop()
 #endif
 		_sync_state_checksum = _state_checksum.state;
 
-		(*_network_server_sync_records)[_network_server_sync_records_next] = { _frame_counter, _random.state[0], _state_checksum.state };
+		(*_network_server_sync_records)[_network_server_sync_records_next] = GetCurrentNetworkSyncRecord();
 		_network_server_sync_records_next = (_network_server_sync_records_next + 1) % _network_server_sync_records->size();
 
 		NetworkServer_Tick(send_frame);
@@ -367,7 +367,7 @@ void ClientNetworkGameSocketHandler::ClientError(NetworkRecvStatus res)
 	}
 
 	if (_network_client_sync_records.size() <= 256) {
-		_network_client_sync_records.push_back({ _frame_counter, _random.state[0], _state_checksum.state });
+		_network_client_sync_records.push_back(GetCurrentNetworkSyncRecord());
 	}
 
 	return true;
@@ -648,6 +648,9 @@ NetworkRecvStatus ClientNetworkGameSocketHandler::SendDesyncSyncData()
 	for (uint i = 0; i < (uint)_network_client_sync_records.size(); i++) {
 		p->Send_uint32(_network_client_sync_records[i].seed_1);
 		p->Send_uint64(_network_client_sync_records[i].state_checksum);
+		for (uint64 checksum : _network_client_sync_records[i].subsystem_state_checksums) {
+			p->Send_uint64(checksum);
+		}
 	}
 	my_client->SendPacket(p);
 	return NETWORK_RECV_STATUS_OKAY;
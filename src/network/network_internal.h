@@ -16,6 +16,7 @@
 
 #include "../command_type.h"
 #include "../date_type.h"
+#include "../core/checksum_func.hpp"
 
 #include <vector>
 #include <array>
@@ -110,7 +111,9 @@ struct NetworkSyncRecord {
 	uint32 frame;
 	uint32 seed_1;
 	uint64 state_checksum;
+	uint64 subsystem_state_checksums[SCS_END];
 };
+NetworkSyncRecord GetCurrentNetworkSyncRecord();
 extern std::vector<NetworkSyncRecord> _network_client_sync_records;
 extern std::unique_ptr<std::array<NetworkSyncRecord, 1024>> _network_server_sync_records;
 extern uint32 _network_server_sync_records_next;
@@ -59,105 +59,124 @@ INSTANTIATE_POOL_METHODS(NetworkClientSocket)
 
 /** Instantiate the listen sockets. */
 template SocketList TCPListenHandler<ServerNetworkGameSocketHandler, PACKET_SERVER_FULL, PACKET_SERVER_BANNED>::sockets;
+#ifdef HAVE_EPOLL
+template int TCPListenHandler<ServerNetworkGameSocketHandler, PACKET_SERVER_FULL, PACKET_SERVER_BANNED>::epoll_fd;
+#endif
 
-/** Writing a savegame directly to a number of packets. */
-struct PacketWriter : SaveFilter {
-	ServerNetworkGameSocketHandler *cs; ///< Socket we are associated with.
-	std::unique_ptr<Packet> current;    ///< The packet we're currently writing to.
-	size_t total_size;                  ///< Total size of the compressed savegame.
-	std::vector<std::unique_ptr<Packet>> packets; ///< Packet queue of the savegame; send these "slowly" to the client.
-	std::unique_ptr<Packet> map_size_packet; ///< Map size packet, fast tracked to the client
-	std::mutex mutex;                   ///< Mutex for making threaded saving safe.
-	std::condition_variable exit_sig;   ///< Signal for threaded destruction of this packet writer.
+/** Maximum number of packets of a map snapshot queued for sending to a client at any one time. */
+static const size_t MAP_SNAPSHOT_QUEUE_PACKETS = 64;
+
+/**
+ * Compressed savegame of the map, shared by all clients which start downloading the map in the same frame.
+ * The packets are written by the savegame thread, and copied to the send queue of each client as it is ready for them.
+ */
+struct NetworkMapSnapshot {
+	const uint32 frame;                           ///< Frame counter at which the snapshot was made.
+	const bool zstd;                              ///< Whether the snapshot may use zstd compression.
+	std::mutex mutex;                             ///< Mutex for the members below, which are written by the savegame thread.
+	std::vector<std::unique_ptr<Packet>> packets; ///< Completed packets of the savegame, the last one is PACKET_SERVER_MAP_DONE once finished.
+	size_t total_size = 0;                        ///< Total size of the compressed savegame, valid once finished.
+	bool finished = false;                        ///< Whether the whole savegame has been written.
+	bool aborted = false;                         ///< Whether writing the savegame has been aborted.
+
+	NetworkMapSnapshot(uint32 frame, bool zstd) : frame(frame), zstd(zstd) {}
 
 	/**
-	 * Create the packet writer.
-	 * @param cs The socket handler we're making the packets for.
+	 * Queue the packets of the snapshot which have not yet been sent to the client, without
+	 * queueing more than #MAP_SNAPSHOT_QUEUE_PACKETS at any one time.
+	 * @param socket The network socket to write to.
+	 * @return True iff the last packet of the map has been queued.
 	 */
-	PacketWriter(ServerNetworkGameSocketHandler *cs) : SaveFilter(nullptr), cs(cs), total_size(0)
+	bool TransferToNetworkQueue(ServerNetworkGameSocketHandler *socket)
 	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+
+		if (this->finished && !socket->map_size_sent) {
+			/* Fast-track the size to the client. Don't queue the PACKET_SERVER_MAP_SIZE before the corresponding PACKET_SERVER_MAP_BEGIN */
+			std::unique_ptr<Packet> p(new Packet(PACKET_SERVER_MAP_SIZE, SHRT_MAX));
+			p->Send_uint32((uint32)this->total_size);
+			socket->SendPrependPacket(std::move(p), PACKET_SERVER_MAP_BEGIN);
+			socket->map_size_sent = true;
+		}
+
+		bool last_packet = false;
+		while (socket->map_packets_sent < this->packets.size() && socket->GetSendQueueSize() < MAP_SNAPSHOT_QUEUE_PACKETS) {
+			const Packet &p = *this->packets[socket->map_packets_sent++];
+			if (p.GetPacketType() == PACKET_SERVER_MAP_DONE) last_packet = true;
+			socket->SendPacket(std::make_unique<Packet>(p));
+		}
+
+		return last_packet;
 	}
+};
 
-	/** Make sure everything is cleaned up. */
-	~PacketWriter()
-	{
-		std::unique_lock<std::mutex> lock(this->mutex);
+/** Most recently started map snapshot, as long as any client still uses it. */
+static std::weak_ptr<NetworkMapSnapshot> _network_map_snapshot;
 
-		if (this->cs != nullptr) this->exit_sig.wait(lock);
+/**
+ * Get the map snapshot of the current frame, if there is one which a client can use.
+ * @param zstd_ok Whether the client supports zstd compression.
+ * @return The snapshot, or nullptr if a new one has to be made.
+ */
+static std::shared_ptr<NetworkMapSnapshot> GetSharedMapSnapshot(bool zstd_ok)
+{
+	std::shared_ptr<NetworkMapSnapshot> snapshot = _network_map_snapshot.lock();
+	if (snapshot == nullptr || snapshot->frame != _frame_counter || (snapshot->zstd && !zstd_ok)) return nullptr;
 
-		/* This must all wait until the Destroy function is called. */
+	std::lock_guard<std::mutex> lock(snapshot->mutex);
+	if (snapshot->aborted) return nullptr;
+	return snapshot;
+}
 
-		this->packets.clear();
-		this->map_size_packet.reset();
-		this->current.reset();
-	}
+/** Writing a savegame directly to the packets of a map snapshot. */
+struct PacketWriter : SaveFilter {
+	std::shared_ptr<NetworkMapSnapshot> snapshot; ///< The snapshot we are writing.
+	std::unique_ptr<Packet> current;              ///< The packet we're currently writing to.
+	size_t total_size;                            ///< Total size of the compressed savegame.
 
 	/**
-	 * Begin the destruction of this packet writer. It can happen in two ways:
-	 * in the first case the client disconnected while saving the map. In this
-	 * case the saving has not finished and killed this PacketWriter. In that
-	 * case we simply set cs to nullptr, triggering the appending to fail due to
-	 * the connection problem and eventually triggering the destructor. In the
-	 * second case the destructor is already called, and it is waiting for our
-	 * signal which we will send. Only then the packets will be removed by the
-	 * destructor.
+	 * Create the packet writer.
+	 * @param snapshot The snapshot to write the packets to.
 	 */
-	void Destroy()
+	PacketWriter(std::shared_ptr<NetworkMapSnapshot> snapshot) : SaveFilter(nullptr), snapshot(std::move(snapshot)), total_size(0)
 	{
-		std::unique_lock<std::mutex> lock(this->mutex);
-
-		this->cs = nullptr;
-
-		this->exit_sig.notify_all();
-		lock.unlock();
+	}
 
-		/* Make sure the saving is completely cancelled. Yes,
-		 * we need to handle the save finish as well as the
-		 * next connection might just be requesting a map. */
-		WaitTillSaved();
+	/** Make sure clients don't wait for a snapshot which will never be finished. */
+	~PacketWriter()
+	{
+		std::lock_guard<std::mutex> lock(this->snapshot->mutex);
+		if (!this->snapshot->finished) this->snapshot->aborted = true;
 	}
 
 	/**
-	 * Transfer all packets from here to the network's queue while holding
-	 * the lock on our mutex.
-	 * @param socket The network socket to write to.
-	 * @return True iff the last packet of the map has been sent.
+	 * Abort the saving when no client uses the snapshot any more.
+	 * The mutex of the snapshot must be held, so that no client can pick up the snapshot in the mean time.
 	 */
-	bool TransferToNetworkQueue(ServerNetworkGameSocketHandler *socket)
+	void CheckAbort()
 	{
-		std::lock_guard<std::mutex> lock(this->mutex);
-
-		if (this->map_size_packet) {
-			/* Don't queue the PACKET_SERVER_MAP_SIZE before the corresponding PACKET_SERVER_MAP_BEGIN */
-			socket->SendPrependPacket(std::move(this->map_size_packet), PACKET_SERVER_MAP_BEGIN);
-		}
-		bool last_packet = false;
-		for (auto &p : this->packets) {
-			if (p->GetPacketType() == PACKET_SERVER_MAP_DONE) last_packet = true;
-			socket->SendPacket(std::move(p));
-
+		if (this->snapshot.use_count() == 1) {
+			this->snapshot->aborted = true;
+			SlError(STR_NETWORK_ERROR_LOSTCONNECTION);
 		}
-		this->packets.clear();
-
-		return last_packet;
 	}
 
-	/** Append the current packet to the queue. */
+	/** Append the current packet to the snapshot. */
 	void AppendQueue()
 	{
 		if (this->current == nullptr) return;
 
-		this->packets.push_back(std::move(this->current));
+		this->snapshot->packets.push_back(std::move(this->current));
 	}
 
 	void Write(byte *buf, size_t size) override
 	{
-		/* We want to abort the saving when the socket is closed. */
-		if (this->cs == nullptr) SlError(STR_NETWORK_ERROR_LOSTCONNECTION);
+		std::unique_lock<std::mutex> lock(this->snapshot->mutex);
 
-		if (this->current == nullptr) this->current.reset(new Packet(PACKET_SERVER_MAP_DATA, SHRT_MAX));
+		/* We want to abort the saving when all sockets are closed. */
+		this->CheckAbort();
 
-		std::lock_guard<std::mutex> lock(this->mutex);
+		if (this->current == nullptr) this->current.reset(new Packet(PACKET_SERVER_MAP_DATA, SHRT_MAX));
 
 		byte *bufe = buf + size;
 		while (buf != bufe) {
@@ -175,10 +194,10 @@ struct PacketWriter : SaveFilter {
 
 	void Finish() override
 	{
-		/* We want to abort the saving when the socket is closed. */
-		if (this->cs == nullptr) SlError(STR_NETWORK_ERROR_LOSTCONNECTION);
+		std::unique_lock<std::mutex> lock(this->snapshot->mutex);
 
-		std::lock_guard<std::mutex> lock(this->mutex);
+		/* We want to abort the saving when all sockets are closed. */
+		this->CheckAbort();
 
 		/* Make sure the last packet is flushed. */
 		this->AppendQueue();
@@ -187,9 +206,8 @@ struct PacketWriter : SaveFilter {
 		this->current.reset(new Packet(PACKET_SERVER_MAP_DONE, SHRT_MAX));
 		this->AppendQueue();
 
-		/* Fast-track the size to the client. */
-		this->map_size_packet.reset(new Packet(PACKET_SERVER_MAP_SIZE, SHRT_MAX));
-		this->map_size_packet->Send_uint32((uint32)this->total_size);
+		this->snapshot->total_size = this->total_size;
+		this->snapshot->finished = true;
 	}
 };
 
@@ -222,11 +240,6 @@ ServerNetworkGameSocketHandler::~ServerNetworkGameSocketHandler()
 
 	extern void RemoveVirtualTrainsOfUser(uint32 user);
 	RemoveVirtualTrainsOfUser(this->client_id);
-
-	if (this->savegame != nullptr) {
-		this->savegame->Destroy();
-		this->savegame = nullptr;
-	}
 }
 
 bool ServerNetworkGameSocketHandler::ParseKeyPasswordPacket(Packet *p, NetworkSharedSecrets &ss, const std::string &password, std::string *payload, size_t length)
@@ -328,9 +341,8 @@ NetworkRecvStatus ServerNetworkGameSocketHandler::CloseConnection(NetworkRecvSta
 	/* If we were transfering a map to this client, stop the savegame creation
 	 * process and queue the next client to receive the map. */
 	if (this->status == STATUS_MAP) {
-		/* Ensure the saving of the game is stopped too. */
-		this->savegame->Destroy();
-		this->savegame = nullptr;
+		/* Release the snapshot, the saving of the game is stopped if no other client uses it. */
+		this->map_snapshot.reset();
 
 		this->CheckNextClientToSendMap(this);
 	}
@@ -608,27 +620,38 @@ NetworkRecvStatus ServerNetworkGameSocketHandler::SendWait()
 
 void ServerNetworkGameSocketHandler::CheckNextClientToSendMap(NetworkClientSocket *ignore_cs)
 {
-	/* Find the best candidate for joining, i.e. the first joiner. */
+	/* Find the best candidate for joining, i.e. the first joiner.
+	 * Prefer clients without zstd support, so that all other waiting clients can share the map snapshot made for it. */
 	NetworkClientSocket *best = nullptr;
+	bool map_in_progress = false;
 	for (NetworkClientSocket *new_cs : NetworkClientSocket::Iterate()) {
 		if (ignore_cs == new_cs) continue;
 
+		if (new_cs->status == STATUS_MAP) map_in_progress = true;
 		if (new_cs->status == STATUS_MAP_WAIT) {
-			if (best == nullptr || best->GetInfo()->join_date > new_cs->GetInfo()->join_date || (best->GetInfo()->join_date == new_cs->GetInfo()->join_date && best->client_id > new_cs->client_id)) {
+			if (best == nullptr || (best->supports_zstd && !new_cs->supports_zstd) ||
+					(best->supports_zstd == new_cs->supports_zstd && (best->GetInfo()->join_date > new_cs->GetInfo()->join_date || (best->GetInfo()->join_date == new_cs->GetInfo()->join_date && best->client_id > new_cs->client_id)))) {
 				best = new_cs;
 			}
 		}
 	}
 
-	/* Is there someone else to join? */
-	if (best != nullptr) {
+	/* Is there someone else to join? Clients still downloading an older snapshot keep the others waiting, unless they can share the one of this frame. */
+	if (best != nullptr && (!map_in_progress || GetSharedMapSnapshot(best->supports_zstd) != nullptr)) {
 		/* Let the first start joining. */
 		best->status = STATUS_AUTHORIZED;
 		best->SendMap();
 
-		/* And update the rest. */
+		/* Let all others which can share its snapshot start joining too, and update the rest. */
 		for (NetworkClientSocket *new_cs : NetworkClientSocket::Iterate()) {
-			if (new_cs->status == STATUS_MAP_WAIT) new_cs->SendWait();
+			if (new_cs->status != STATUS_MAP_WAIT) continue;
+
+			if (GetSharedMapSnapshot(new_cs->supports_zstd) != nullptr) {
+				new_cs->status = STATUS_AUTHORIZED;
+				new_cs->SendMap();
+			} else {
+				new_cs->SendWait();
+			}
 		}
 	}
 }
@@ -642,8 +665,17 @@ NetworkRecvStatus ServerNetworkGameSocketHandler::SendMap()
 	}
 
 	if (this->status == STATUS_AUTHORIZED) {
-		WaitTillSaved();
-		this->savegame = new PacketWriter(this);
+		/* Share the snapshot of the map if another client already started downloading it in this frame. */
+		std::shared_ptr<NetworkMapSnapshot> snapshot = GetSharedMapSnapshot(this->supports_zstd);
+		const bool new_snapshot = (snapshot == nullptr);
+		if (new_snapshot) {
+			WaitTillSaved();
+			snapshot = std::make_shared<NetworkMapSnapshot>(_frame_counter, this->supports_zstd);
+			_network_map_snapshot = snapshot;
+		}
+		this->map_snapshot = snapshot;
+		this->map_packets_sent = 0;
+		this->map_size_sent = false;
 
 		/* Now send the _frame_counter and how many packets are coming */
 		Packet *p = new Packet(PACKET_SERVER_MAP_BEGIN, SHRT_MAX);
@@ -656,18 +688,21 @@ NetworkRecvStatus ServerNetworkGameSocketHandler::SendMap()
 		this->last_frame = _frame_counter;
 		this->last_frame_server = _frame_counter;
 
-		/* Make a dump of the current game */
-		SaveModeFlags flags = SMF_NET_SERVER;
-		if (this->supports_zstd) flags |= SMF_ZSTD_OK;
-		if (SaveWithFilter(this->savegame, true, flags) != SL_OK) usererror("network savedump failed");
+		if (new_snapshot) {
+			/* Make a dump of the current game */
+			SaveModeFlags flags = SMF_NET_SERVER;
+			if (snapshot->zstd) flags |= SMF_ZSTD_OK;
+			if (SaveWithFilter(new PacketWriter(std::move(snapshot)), true, flags) != SL_OK) usererror("network savedump failed");
+		} else {
+			DEBUG(net, 3, "[%s] Client #%u shares the map snapshot of frame %u", ServerNetworkGameSocketHandler::GetName(), this->client_id, snapshot->frame);
+		}
 	}
 
 	if (this->status == STATUS_MAP) {
-		bool last_packet = this->savegame->TransferToNetworkQueue(this);
+		bool last_packet = this->map_snapshot->TransferToNetworkQueue(this);
 		if (last_packet) {
-			/* Done reading, make sure saving is done as well */
-			this->savegame->Destroy();
-			this->savegame = nullptr;
+			/* Done reading, release the snapshot */
+			this->map_snapshot.reset();
 
 			/* Set the status to DONE_MAP, no we will wait for the client
 			 *  to send it is ready (maybe that happens like never ;)) */
@@ -1128,9 +1163,9 @@ NetworkRecvStatus ServerNetworkGameSocketHandler::Receive_CLIENT_GETMAP(Packet *
 
 	this->supports_zstd = p->Recv_bool();
 
-	/* Check if someone else is receiving the map */
+	/* Check if someone else is receiving the map, and it can't be shared with this client */
 	for (NetworkClientSocket *new_cs : NetworkClientSocket::Iterate()) {
-		if (new_cs->status == STATUS_MAP) {
+		if (new_cs->status == STATUS_MAP && GetSharedMapSnapshot(this->supports_zstd) == nullptr) {
 			/* Tell the new client to wait */
 			this->status = STATUS_MAP_WAIT;
 			return this->SendWait();
@@ -1295,6 +1330,7 @@ NetworkRecvStatus ServerNetworkGameSocketHandler::Receive_CLIENT_ERROR(Packet *p
 		info.client_id = this->client_id;
 		info.desync_frame_seed = this->desync_frame_seed;
 		info.desync_frame_state_checksum = this->desync_frame_state_checksum;
+		info.desync_frame_state_subsystems = this->desync_frame_state_subsystems;
 		CrashLog::DesyncCrashLog(&(this->desync_log), &server_desync_log, info);
 		this->SendDesyncLog(server_desync_log);
 
@@ -1355,12 +1391,21 @@ NetworkRecvStatus ServerNetworkGameSocketHandler::Receive_CLIENT_DESYNC_SYNC_DAT
 	for (uint i = 0; i < count; i++) {
 		uint32 seed_1 = p->Recv_uint32();
 		uint64 state_checksum = p->Recv_uint64();
+		uint64 subsystem_state_checksums[SCS_END];
+		for (uint64 &checksum : subsystem_state_checksums) {
+			checksum = p->Recv_uint64();
+		}
 
 		const NetworkSyncRecord &record = (*_network_server_sync_records)[server_idx];
 
 		if (record.frame != frame) break;
 		if (record.seed_1 != seed_1 && this->desync_frame_seed == 0) this->desync_frame_seed = frame;
-		if (record.state_checksum != state_checksum && this->desync_frame_state_checksum == 0) this->desync_frame_state_checksum = frame;
+		if (record.state_checksum != state_checksum && this->desync_frame_state_checksum == 0) {
+			this->desync_frame_state_checksum = frame;
+			for (uint j = 0; j < SCS_END; j++) {
+				if (record.subsystem_state_checksums[j] != subsystem_state_checksums[j]) SetBit(this->desync_frame_state_subsystems, j);
+			}
+		}
 
 		frame++;
 		server_idx = (server_idx + 1) % _network_server_sync_records->size();
@@ -85,13 +85,16 @@ public:
 	bool settings_authed = false;///< Authorised to control all game settings
 	bool supports_zstd = false;  ///< Client supports zstd compression
 
-	struct PacketWriter *savegame; ///< Writer used to write the savegame.
+	std::shared_ptr<struct NetworkMapSnapshot> map_snapshot; ///< Snapshot of the map being sent to the client.
+	size_t map_packets_sent = 0;   ///< Number of packets of map_snapshot which have been queued for sending.
+	bool map_size_sent = false;    ///< Whether the size of map_snapshot has been queued for sending.
 	NetworkAddress client_address; ///< IP-address of the client (so they can be banned)
 
 	std::string desync_log;
 
 	uint desync_frame_seed = 0;
 	uint desync_frame_state_checksum = 0;
+	uint desync_frame_state_subsystems = 0; ///< Bit mask of the StateChecksumSubsystem checksums which differed at desync_frame_state_checksum.
 
 	uint rcon_auth_failures = 0;
 	uint settings_auth_failures = 0;
@@ -93,6 +93,7 @@
 
 #include "linkgraph/linkgraphschedule.h"
 #include "tracerestrict.h"
+#include "pathfinder/yapf/yapf_stats.h"
 
 #include "3rdparty/cpp-btree/btree_set.h"
 
@@ -133,6 +134,27 @@ bool _request_newgrf_scan = false;
 NewGRFScanCallback *_request_newgrf_scan_callback = nullptr;
 
 SimpleChecksum64 _state_checksum;
+SimpleChecksum64 _subsystem_state_checksums[SCS_END];
+
+/**
+ * Get the name of a part of the game state which has its own checksum.
+ * @param subsystem The part of the game state.
+ * @return The name, for desync reports.
+ */
+const char *GetStateChecksumSubsystemName(StateChecksumSubsystem subsystem)
+{
+	static const char * const names[] = {
+		"trains",
+		"road vehicles",
+		"ships",
+		"aircraft",
+		"other vehicles",
+		"companies",
+		"stations",
+	};
+	static_assert(lengthof(names) == SCS_END);
+	return names[subsystem];
+}
 
 /**
  * Error handling for fatal user errors.
@@ -2020,6 +2042,8 @@ void StateGameLoop()
 		PerformanceMeasurer::Paused(PFE_GL_SHIPS);
 		PerformanceMeasurer::Paused(PFE_GL_AIRCRAFT);
 		PerformanceMeasurer::Paused(PFE_GL_LANDSCAPE);
+		TileLoopProfileBeginTick(true);
+		YapfStatsBeginTick(true);
 
 		if (!HasModalProgress()) UpdateLandscapingLimits();
 #ifndef DEBUG_DUMP_COMMANDS
@@ -2030,6 +2054,8 @@ void StateGameLoop()
 
 	PerformanceMeasurer framerate(PFE_GAMELOOP);
 	PerformanceAccumulator::Reset(PFE_GL_LANDSCAPE);
+	TileLoopProfileBeginTick(false);
+	YapfStatsBeginTick(false);
 
 	Layouter::ReduceLineCache();
 
@@ -2105,24 +2131,24 @@ void StateGameLoop()
 		if (_networking) {
 			for (Company *c : Company::Iterate()) {
 				DEBUG_UPDATESTATECHECKSUM("Company: %u, Money: " OTTD_PRINTF64, c->index, (int64)c->money);
-				UpdateStateChecksum(c->money);
+				UpdateStateChecksum(c->money, SCS_COMPANIES);
 
 				for (uint i = 0; i < ROADTYPE_END; i++) {
 					DEBUG_UPDATESTATECHECKSUM("Company: %u, road[%u]: %u", c->index, i, c->infrastructure.road[i]);
-					UpdateStateChecksum(c->infrastructure.road[i]);
+					UpdateStateChecksum(c->infrastructure.road[i], SCS_COMPANIES);
 				}
 
 				for (uint i = 0; i < RAILTYPE_END; i++) {
 					DEBUG_UPDATESTATECHECKSUM("Company: %u, rail[%u]: %u", c->index, i, c->infrastructure.rail[i]);
-					UpdateStateChecksum(c->infrastructure.rail[i]);
+					UpdateStateChecksum(c->infrastructure.rail[i], SCS_COMPANIES);
 				}
 
 				DEBUG_UPDATESTATECHECKSUM("Company: %u, signal: %u, water: %u, station: %u, airport: %u",
 						c->index, c->infrastructure.signal, c->infrastructure.water, c->infrastructure.station, c->infrastructure.airport);
-				UpdateStateChecksum(c->infrastructure.signal);
-				UpdateStateChecksum(c->infrastructure.water);
-				UpdateStateChecksum(c->infrastructure.station);
-				UpdateStateChecksum(c->infrastructure.airport);
+				UpdateStateChecksum(c->infrastructure.signal, SCS_COMPANIES);
+				UpdateStateChecksum(c->infrastructure.water, SCS_COMPANIES);
+				UpdateStateChecksum(c->infrastructure.station, SCS_COMPANIES);
+				UpdateStateChecksum(c->infrastructure.airport, SCS_COMPANIES);
 			}
 		}
 		cur_company.Restore();
@@ -10,35 +10,187 @@
 #ifndef NODELIST_HPP
 #define NODELIST_HPP
 
-#include "../../misc/array.hpp"
 #include "../../misc/hashtable.hpp"
 #include "../../misc/binaryheap.hpp"
+#include "../../core/alloc_func.hpp"
+#include "../../core/bitmath_func.hpp"
+#include "../../core/math_func.hpp"
+#include "../../string_func.h"
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+extern bool _yapf_node_list_pool_disabled;
+
+/**
+ * Storage of the nodes, hash tables and priority queue of a CNodeList_HashTableT.
+ *  Storages are kept in a per thread pool and reused by the following searches,
+ *  so the memory of the node chunks, hash slots and queue is not allocated for
+ *  every search. Resetting a storage for the next search is O(1), the amount of
+ *  memory which is retained is adapted to the size of the recent searches.
+ */
+template <class Titem_>
+class CNodeListStorageT {
+public:
+	typedef CResettableHashTableT<Titem_> CHashTable;            ///< How pointers to open and closed nodes will be stored.
+	typedef CBinaryHeapT<Titem_> CPriorityQueue;                 ///< How the priority queue will be managed.
+
+	static const uint CHUNK_BITS = 12;                           ///< Number of nodes per chunk, as power of two.
+	static const uint CHUNK_SIZE = 1 << CHUNK_BITS;              ///< Number of nodes per chunk.
+	static const uint MAX_HASH_BITS = 16;                        ///< Upper limit of the adaptive hash table size.
+
+	/* Nodes are forgotten without calling their destructor on reset. */
+	static_assert(std::is_trivially_destructible<Titem_>::value);
+
+private:
+	std::vector<Titem_ *> chunks; ///< Node chunks, each holding CHUNK_SIZE nodes.
+	uint num_items = 0;           ///< Number of nodes in use.
+	uint recent_peak = 0;         ///< Decaying maximum of the number of nodes used by the recent searches.
+	const uint open_bits_min;     ///< Minimum hash bits of the open list.
+	const uint closed_bits_min;   ///< Minimum hash bits of the closed list.
+
+public:
+	CHashTable     open;          ///< Hash table of pointers to open item data.
+	CHashTable     closed;        ///< Hash table of pointers to closed item data.
+	CPriorityQueue open_queue;    ///< Priority queue of pointers to open item data.
+
+	CNodeListStorageT(uint open_bits_min, uint closed_bits_min) : open_bits_min(open_bits_min), closed_bits_min(closed_bits_min),
+			open(open_bits_min), closed(closed_bits_min), open_queue(2048) {}
+
+	~CNodeListStorageT()
+	{
+		for (Titem_ *chunk : this->chunks) free(chunk);
+	}
+
+	/** allocate and construct new item */
+	inline Titem_ *AppendC()
+	{
+		const uint chunk = this->num_items >> CHUNK_BITS;
+		if (chunk == this->chunks.size()) this->chunks.push_back(MallocT<Titem_>(CHUNK_SIZE));
+		Titem_ *item = this->chunks[chunk] + (this->num_items & (CHUNK_SIZE - 1));
+		this->num_items++;
+		new(item) Titem_;
+		return item;
+	}
+
+	/** return number of items */
+	inline uint Length() const
+	{
+		return this->num_items;
+	}
+
+	/** indexed access (non-const) */
+	inline Titem_ &operator[](uint index)
+	{
+		return this->chunks[index >> CHUNK_BITS][index & (CHUNK_SIZE - 1)];
+	}
+
+	/** indexed access (const) */
+	inline const Titem_ &operator[](uint index) const
+	{
+		return this->chunks[index >> CHUNK_BITS][index & (CHUNK_SIZE - 1)];
+	}
+
+	/**
+	 * Forget all nodes, and adapt the retained memory to the size of the recent searches.
+	 * The node chunks which were not needed recently are freed, the hash tables are sized
+	 * for about one node per slot.
+	 */
+	void Reset()
+	{
+		this->recent_peak = std::max(this->num_items, this->recent_peak - this->recent_peak / 8);
+		this->num_items = 0;
+
+		const size_t keep_chunks = std::max<size_t>(1, CeilDiv(this->recent_peak, CHUNK_SIZE));
+		while (this->chunks.size() > keep_chunks) {
+			free(this->chunks.back());
+			this->chunks.pop_back();
+		}
+
+		const uint peak_bits = FindLastBit(std::max<uint>(this->recent_peak, 1)) + 1;
+		this->open.Reset(Clamp<uint>(peak_bits - 1, this->open_bits_min, MAX_HASH_BITS));
+		this->closed.Reset(Clamp<uint>(peak_bits, this->closed_bits_min, MAX_HASH_BITS));
+		this->open_queue.Clear();
+	}
+
+	/** Get the pool of unused storages of the current thread. */
+	static std::vector<std::unique_ptr<CNodeListStorageT>> &GetPool()
+	{
+		static thread_local std::vector<std::unique_ptr<CNodeListStorageT>> pool;
+		return pool;
+	}
+
+	/**
+	 * Get a storage for a new node list, reusing one of the current thread when available.
+	 * @param open_bits_min Minimum hash bits of the open list.
+	 * @param closed_bits_min Minimum hash bits of the closed list.
+	 * @return The empty storage.
+	 */
+	static std::unique_ptr<CNodeListStorageT> Acquire(uint open_bits_min, uint closed_bits_min)
+	{
+		std::vector<std::unique_ptr<CNodeListStorageT>> &pool = GetPool();
+		for (auto it = pool.rbegin(); it != pool.rend(); ++it) {
+			if ((*it)->open_bits_min != open_bits_min || (*it)->closed_bits_min != closed_bits_min) continue;
+			std::unique_ptr<CNodeListStorageT> storage = std::move(*it);
+			pool.erase(std::next(it).base());
+			return storage;
+		}
+		return std::make_unique<CNodeListStorageT>(open_bits_min, closed_bits_min);
+	}
+
+	/**
+	 * Return a storage which is no longer used to the pool of the current thread.
+	 * @param storage The storage.
+	 */
+	static void Release(std::unique_ptr<CNodeListStorageT> storage)
+	{
+		if (_yapf_node_list_pool_disabled) return;
+		storage->Reset();
+		GetPool().push_back(std::move(storage));
+	}
+
+	/**
+	 * Helper for creating a human readable output of this data.
+	 * @param dmp The location to dump to.
+	 */
+	template <typename D> void Dump(D &dmp) const
+	{
+		dmp.WriteValue("num_chunks", (uint)this->chunks.size());
+		dmp.WriteValue("num_items", this->num_items);
+		for (uint i = 0; i < this->num_items; i++) {
+			char name[32];
+			seprintf(name, lastof(name), "item[%d]", i);
+			dmp.WriteStructT(name, &(*this)[i]);
+		}
+	}
+};
 
 /**
  * Hash table based node list multi-container class.
  *  Implements open list, closed list and priority queue for A-star
  *  path finder.
+ *  The containers are borrowed from the per thread pool of CNodeListStorageT
+ *  for the lifetime of the node list.
  */
 template <class Titem_, int Thash_bits_open_, int Thash_bits_closed_>
 class CNodeList_HashTableT {
 public:
 	typedef Titem_ Titem;                                        ///< Make #Titem_ visible from outside of class.
 	typedef typename Titem_::Key Key;                            ///< Make Titem_::Key a property of this class.
-	typedef SmallArray<Titem_, 65536, 256> CItemArray;           ///< Type that we will use as item container.
-	typedef CHashTableT<Titem_, Thash_bits_open_  > COpenList;   ///< How pointers to open nodes will be stored.
-	typedef CHashTableT<Titem_, Thash_bits_closed_> CClosedList; ///< How pointers to closed nodes will be stored.
-	typedef CBinaryHeapT<Titem_> CPriorityQueue;                 ///< How the priority queue will be managed.
+	typedef CNodeListStorageT<Titem_> CStorage;                  ///< Type that we will use as item, hash table and queue container.
 
 protected:
-	CItemArray      m_arr;        ///< Here we store full item data (Titem_).
-	COpenList       m_open;       ///< Hash table of pointers to open item data.
-	CClosedList     m_closed;     ///< Hash table of pointers to closed item data.
-	CPriorityQueue  m_open_queue; ///< Priority queue of pointers to open item data.
+	std::unique_ptr<CStorage> m_storage; ///< Here we store full item data (Titem_), the open and closed lists and the priority queue.
+	CStorage       &m_arr;        ///< Here we store full item data (Titem_).
+	typename CStorage::CHashTable &m_open;       ///< Hash table of pointers to open item data.
+	typename CStorage::CHashTable &m_closed;     ///< Hash table of pointers to closed item data.
+	typename CStorage::CPriorityQueue &m_open_queue; ///< Priority queue of pointers to open item data.
 	Titem          *m_new_node;   ///< New open node under construction.
 
 public:
 	/** default constructor */
-	CNodeList_HashTableT() : m_open_queue(2048)
+	CNodeList_HashTableT() : m_storage(CStorage::Acquire(Thash_bits_open_, Thash_bits_closed_)), m_arr(*m_storage),
+			m_open(m_storage->open), m_closed(m_storage->closed), m_open_queue(m_storage->open_queue)
 	{
 		m_new_node = nullptr;
 	}
@@ -46,8 +198,12 @@ public:
 	/** destructor */
 	~CNodeList_HashTableT()
 	{
+		CStorage::Release(std::move(m_storage));
 	}
 
+	CNodeList_HashTableT(const CNodeList_HashTableT &) = delete;
+	CNodeList_HashTableT &operator=(const CNodeList_HashTableT &) = delete;
+
 	/** return number of open nodes */
 	inline int OpenCount()
 	{
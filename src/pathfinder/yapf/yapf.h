@@ -16,6 +16,7 @@
 #include "../../ship.h"
 #include "../../roadveh.h"
 #include "../pathfinder_type.h"
+#include <vector>
 
 /**
  * Finds the best path for given ship using YAPF.
@@ -47,6 +48,35 @@ bool YapfShipCheckReverse(const Ship *v, Trackdir *trackdir);
  */
 Trackdir YapfRoadVehicleChooseTrack(const RoadVehicle *v, TileIndex tile, DiagDirection enterdir, TrackdirBits trackdirs, bool &path_found, RoadVehPathCache &path_cache);
 
+/** Request for the path of a road vehicle or ship which is expected to enter a new tile in the current tick. */
+struct YapfPathRequest {
+	const Vehicle *v;       ///< the vehicle
+	TileIndex tile;         ///< the tile the vehicle is about to enter
+	DiagDirection enterdir; ///< diagonal direction which the vehicle will enter this new tile from
+	TrackBits tracks;       ///< available tracks on the new tile, ships only
+};
+
+/**
+ * Resolve the paths of road vehicles on the worker pool, ahead of the road vehicle tick loop.
+ * YapfRoadVehicleChooseTrack uses a result only when it is called for the same request and the
+ * state which the search read is unchanged, so the outcome is the same as that of a serial search.
+ * @param requests the requests, they are sorted by vehicle
+ */
+void YapfRoadVehiclePrefetchPaths(std::vector<YapfPathRequest> &requests);
+
+/**
+ * Resolve the paths of ships on the worker pool, ahead of the ship tick loop.
+ * @param requests the requests, they are sorted by vehicle
+ * @see YapfRoadVehiclePrefetchPaths
+ */
+void YapfShipPrefetchPaths(std::vector<YapfPathRequest> &requests);
+
+/** Discard the prefetched road vehicle paths which were not used, at the end of the road vehicle tick loop. */
+void YapfRoadVehicleDiscardPrefetchedPaths();
+
+/** Discard the prefetched ship paths which were not used, at the end of the ship tick loop. */
+void YapfShipDiscardPrefetchedPaths();
+
 /**
  * Finds the best path for given train using YAPF.
  * @param v        the train that needs to find a path
@@ -12,6 +12,8 @@
 
 #include "../../debug.h"
 #include "../../settings_type.h"
+#include "yapf_stats.h"
+#include <chrono>
 
 /**
  * CYapfBaseT - A-star type path finder base class.
@@ -109,9 +111,11 @@ public:
 	inline bool FindPath(const VehicleType *v)
 	{
 		m_veh = v;
+		const auto start_time = std::chrono::steady_clock::now();
 
 		Yapf().PfSetStartupNodes();
 		bool bDestFound = true;
+		bool cutoff = false;
 
 		for (;;) {
 			m_num_steps++;
@@ -133,12 +137,23 @@ public:
 			} else {
 				m_nodes.ReenqueueOpenNode(*n);
 				bDestFound = false;
+				cutoff = true;
 				break;
 			}
 		}
 
 		bDestFound &= (m_pBestDestNode != nullptr);
 
+		YapfSearchRecord record;
+		record.ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start_time).count();
+		record.nodes_opened = m_nodes.OpenCount() + m_nodes.ClosedCount();
+		record.nodes_closed = m_nodes.ClosedCount();
+		record.cost_calcs = m_stats_cost_calcs;
+		record.cache_hits = m_stats_cache_hits;
+		record.path_found = bDestFound;
+		record.cutoff = cutoff;
+		RecordYapfSearch(VehicleType::EXPECTED_TYPE, (v != nullptr) ? v->index : INVALID_VEHICLE, (v != nullptr) ? v->tile : INVALID_TILE, record);
+
 		if (_debug_yapf_level >= 3) {
 			UnitID veh_idx = (m_veh != nullptr) ? m_veh->unitnumber : 0;
 			char ttc = Yapf().TransportTypeChar();
@@ -19,4 +19,6 @@
  */
 void YapfNotifyTrackLayoutChange(TileIndex tile, Track track);
 
+void YapfFlushRailRouteCache();
+
 #endif /* YAPF_CACHE_H */
@@ -11,6 +11,8 @@
 #define YAPF_COSTCACHE_HPP
 
 #include "../../date_func.h"
+#include "../../3rdparty/cpp-btree/btree_map.h"
+#include <vector>
 
 /**
  * CYapfSegmentCostCacheNoneT - the formal only yapf cost cache provider that implements
@@ -91,20 +93,60 @@ public:
 
 
 /**
- * Base class for segment cost cache providers. Contains global counter
- *  of track layout changes and static notification function called whenever
- *  the track layout changes. It is implemented as base class because it needs
- *  to be shared between all rail YAPF types (one shared counter, one notification
- *  function.
+ * Base class for segment cost caches. Contains the registry of all segment
+ *  cost caches and the static notification function called whenever the
+ *  track layout changes. It is implemented as base class because it needs
+ *  to be shared between all rail YAPF types (one registry, one notification
+ *  function).
+ *
+ * Track layout changes are not applied immediately, as cached segments may
+ *  be referenced by the nodes of a currently running pathfinder. Instead the
+ *  changed tiles are queued for each cache, and only the segments which touch
+ *  one of the changed tiles are evicted the next time the cache is fetched.
  */
 struct CSegmentCostCacheBase
 {
-	static int   s_rail_change_counter;
+	/** Segment cost cache statistics, accumulated over all caches. */
+	struct Stats {
+		uint64 hits = 0;           ///< number of global cache lookups which found a valid segment
+		uint64 misses = 0;         ///< number of global cache lookups which did not find a valid segment
+		uint64 evictions = 0;      ///< number of segments evicted due to track layout changes
+		uint64 flushes = 0;        ///< number of whole cache flushes
+	};
 
-	static void NotifyTrackLayoutChange(TileIndex tile, Track track)
+	static const uint C_MAX_PENDING_TILES = 4096; ///< flush the whole cache instead of evicting segments when more tiles than this have changed
+
+	static Stats s_stats;
+
+	std::vector<TileIndex> m_pending_tiles;       ///< tiles which changed since the last call to ApplyPendingChanges
+	bool                   m_pending_flush;       ///< whether the whole cache should be flushed by the next call to ApplyPendingChanges
+
+	CSegmentCostCacheBase();
+	virtual ~CSegmentCostCacheBase();
+
+	virtual void Flush() = 0;
+	virtual void EvictTile(TileIndex tile) = 0;
+	virtual uint Size() const = 0;
+
+	/** apply the queued track layout changes */
+	void ApplyPendingChanges()
 	{
-		s_rail_change_counter++;
+		if (m_pending_flush) {
+			Flush();
+		} else {
+			for (TileIndex tile : m_pending_tiles) {
+				EvictTile(tile);
+			}
+		}
+		m_pending_tiles.clear();
+		m_pending_flush = false;
 	}
+
+	static void NotifyTrackLayoutChange(TileIndex tile, Track track);
+	static uint TotalSize();
+
+private:
+	static std::vector<CSegmentCostCacheBase *> &Caches();
 };
 
 
@@ -116,11 +158,14 @@ struct CSegmentCostCacheBase
  *  be always the same (TileIndex + DiagDirection) that represent the beginning
  *  of the segment (origin tile and exit-dir from this tile).
  *  Different CYapfCachedCostT types can share the same type of CSegmentCostCacheT.
- *  Look at CYapfRailSegment (yapf_node_rail.hpp) for the segment example
+ *  Look at CYapfRailSegment (yapf_node_rail.hpp) for the segment example.
+ *  Segments are additionally indexed by the tiles they touch, such that a
+ *  track layout change only evicts the segments crossing the changed tile.
  */
 template <class Tsegment>
 struct CSegmentCostCacheT : public CSegmentCostCacheBase {
 	static const int C_HASH_BITS = 14;
+	static const uint C_MAX_SEGMENTS = 1 << 17; ///< flush the whole cache when the storage grows beyond this
 
 	typedef CHashTableT<Tsegment, C_HASH_BITS> HashTable;
 	typedef SmallArray<Tsegment> Heap;
@@ -128,14 +173,44 @@ struct CSegmentCostCacheT : public CSegmentCostCacheBase {
 
 	HashTable    m_map;
 	Heap         m_heap;
+	std::vector<Tsegment *> m_free;                ///< evicted segments which can be reused
+	btree::btree_multimap<TileIndex, Key> m_tiles; ///< keys of the segments touching each tile, may contain stale keys
 
 	inline CSegmentCostCacheT() {}
 
 	/** flush (clear) the cache */
-	inline void Flush()
+	void Flush() override
 	{
+		if (m_heap.Length() == 0) return;
 		m_map.Clear();
 		m_heap.Clear();
+		m_free.clear();
+		m_tiles.clear();
+		s_stats.flushes++;
+	}
+
+	/** evict all segments touching the given tile */
+	void EvictTile(TileIndex tile) override
+	{
+		auto range = m_tiles.equal_range(tile);
+		for (auto it = range.first; it != range.second; ++it) {
+			Tsegment *item = m_map.TryPop(it->second);
+			if (item == nullptr) continue;
+			m_free.push_back(item);
+			s_stats.evictions++;
+		}
+		m_tiles.erase(range.first, range.second);
+	}
+
+	uint Size() const override
+	{
+		return m_map.Count();
+	}
+
+	/** flush the cache if its storage has grown too large */
+	inline void CheckSize()
+	{
+		if (m_heap.Length() >= C_MAX_SEGMENTS || m_tiles.size() >= C_MAX_SEGMENTS * 16) Flush();
 	}
 
 	inline Tsegment& Get(Key &key, bool *found)
@@ -143,13 +218,26 @@ struct CSegmentCostCacheT : public CSegmentCostCacheBase {
 		Tsegment *item = m_map.Find(key);
 		if (item == nullptr) {
 			*found = false;
-			item = new (m_heap.Append()) Tsegment(key);
+			if (!m_free.empty()) {
+				item = new (m_free.back()) Tsegment(key);
+				m_free.pop_back();
+			} else {
+				item = new (m_heap.Append()) Tsegment(key);
+			}
 			m_map.Push(*item);
 		} else {
 			*found = true;
 		}
 		return *item;
 	}
+
+	/** record the tiles touched by the given segment */
+	inline void AddSegmentTiles(const Tsegment &item, const std::vector<TileIndex> &tiles)
+	{
+		for (TileIndex tile : tiles) {
+			m_tiles.insert({ tile, item.GetKey() });
+		}
+	}
 };
 
 /**
@@ -181,14 +269,11 @@ protected:
 
 	inline static Cache& stGetGlobalCache()
 	{
-		static int last_rail_change_counter = 0;
 		static Cache C;
 
-		/* delete the cache sometimes... */
-		if (last_rail_change_counter != Cache::s_rail_change_counter) {
-			last_rail_change_counter = Cache::s_rail_change_counter;
-			C.Flush();
-		}
+		/* evict the segments affected by track layout changes */
+		C.ApplyPendingChanges();
+		C.CheckSize();
 		return C;
 	}
 
@@ -206,6 +291,11 @@ public:
 		bool found;
 		CachedData &item = m_global_cache.Get(key, &found);
 		Yapf().ConnectNodeToCachedData(n, item);
+		if (found && item.m_cost >= 0) {
+			Cache::s_stats.hits++;
+		} else {
+			Cache::s_stats.misses++;
+		}
 		return found;
 	}
 
@@ -216,6 +306,15 @@ public:
 	inline void PfNodeCacheFlush(Node &n)
 	{
 	}
+
+	/**
+	 * Called by YAPF when the cost of a globally cached segment has been calculated.
+	 *  Records the tiles which the segment touches, such that it is evicted when one of them changes.
+	 */
+	inline void PfNodeCacheSegmentTiles(Node &n, const std::vector<TileIndex> &tiles)
+	{
+		m_global_cache.AddSegmentTiles(*n.m_segment, tiles);
+	}
 };
 
 #endif /* YAPF_COSTCACHE_HPP */
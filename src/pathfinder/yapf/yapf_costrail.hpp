@@ -58,14 +58,18 @@ protected:
 	int m_max_cost;
 	bool m_disable_cache;
 	std::vector<int> m_sig_look_ahead_costs;
+	std::vector<TileIndex> m_segment_tiles; ///< tiles touched by the segment currently being calculated, for the global segment cost cache
 
 public:
 	bool          m_stopped_on_first_two_way_signal;
+	bool          m_record_route_regions;  ///< whether to record the rail state regions the search depends on, for the route cache
+	bool          m_route_uncacheable;     ///< the search depended on state which the route cache does not track
+	std::vector<uint> m_route_regions;     ///< rail state regions the search depended on, may contain duplicates
 protected:
 
 	static const int s_max_segment_cost = 10000;
 
-	CYapfCostRailT() : m_max_cost(0), m_disable_cache(false), m_stopped_on_first_two_way_signal(false)
+	CYapfCostRailT() : m_max_cost(0), m_disable_cache(false), m_stopped_on_first_two_way_signal(false), m_record_route_regions(false), m_route_uncacheable(false)
 	{
 		/* pre-compute look-ahead penalties into array */
 		int p0 = Yapf().PfGetSettings().rail_look_ahead_signal_p0;
@@ -301,7 +305,8 @@ private:
 			flags_to_check |= TRPAUF_REVERSE;
 		}
 		if (prog && prog->actions_used_flags & flags_to_check) {
-			prog->Execute(Yapf().GetVehicle(), TraceRestrictProgramInput(tile, trackdir, &TraceRestrictPreviousSignalCallback, &n), out);
+			if (prog->has_dynamic_conditions) m_route_uncacheable = true;
+			prog->Execute(Yapf().GetVehicle(), TraceRestrictProgramInput(tile, trackdir, &TraceRestrictPreviousSignalCallback, &n), out, flags_to_check);
 			if (out.flags & TRPRF_RESERVE_THROUGH && is_res_through != nullptr) {
 				*is_res_through = true;
 			}
@@ -327,7 +332,8 @@ private:
 		const TraceRestrictProgram *prog = GetExistingTraceRestrictProgram(tile, TrackdirToTrack(trackdir));
 		TraceRestrictProgramActionsUsedFlags flags_to_check = TRPAUF_PF;
 		if (prog && prog->actions_used_flags & flags_to_check) {
-			prog->Execute(Yapf().GetVehicle(), TraceRestrictProgramInput(tile, trackdir, &TraceRestrictPreviousSignalCallback, &n), out);
+			if (prog->has_dynamic_conditions) m_route_uncacheable = true;
+			prog->Execute(Yapf().GetVehicle(), TraceRestrictProgramInput(tile, trackdir, &TraceRestrictPreviousSignalCallback, &n), out, flags_to_check);
 			if (out.flags & TRPRF_DENY) {
 				n.m_segment->m_end_segment_reason |= ESRB_DEAD_END;
 				return true;
@@ -429,8 +435,9 @@ public:
 						if (ShouldCheckTraceRestrict(n, tile)) {
 							const TraceRestrictProgram *prog = GetExistingTraceRestrictProgram(tile, TrackdirToTrack(trackdir));
 							if (prog && prog->actions_used_flags & TRPAUF_PF) {
+								if (prog->has_dynamic_conditions) m_route_uncacheable = true;
 								TraceRestrictProgramResult out;
-								prog->Execute(Yapf().GetVehicle(), TraceRestrictProgramInput(tile, trackdir, &TraceRestrictPreviousSignalCallback, &n), out);
+								prog->Execute(Yapf().GetVehicle(), TraceRestrictProgramInput(tile, trackdir, &TraceRestrictPreviousSignalCallback, &n), out, TRPAUF_PF);
 								if (out.flags & TRPRF_DENY) {
 									n.m_segment->m_end_segment_reason |= ESRB_DEAD_END;
 									return -1;
@@ -498,6 +505,29 @@ public:
 		return cost;
 	}
 
+	/** Record the tiles which the given track follower entered or skipped. */
+	inline void RecordSegmentTiles(const TrackFollower &tf)
+	{
+		if (tf.m_new_tile == INVALID_TILE) return;
+		if (tf.m_is_station) {
+			TileIndexDiff diff = TileOffsByDiagDir(tf.m_exitdir);
+			for (TileIndex tile = tf.m_new_tile - diff * tf.m_tiles_skipped; tile != tf.m_new_tile; tile += diff) {
+				m_segment_tiles.push_back(tile);
+			}
+		}
+		m_segment_tiles.push_back(tf.m_new_tile);
+	}
+
+	/** Record the rail state regions of the given tile and of the tiles skipped before reaching it, for the route cache. */
+	inline void RecordRouteRegions(TileIndex tile, Trackdir trackdir, int skipped)
+	{
+		TileIndexDiff diff = TileOffsByDiagDir(TrackdirToExitdir(ReverseTrackdir(trackdir)));
+		for (; skipped >= 0; skipped--, tile += diff) {
+			uint region = GetRailStateRegionIndex(tile);
+			if (m_route_regions.empty() || m_route_regions.back() != region) m_route_regions.push_back(region);
+		}
+	}
+
 public:
 	inline void SetMaxCost(int max_cost)
 	{
@@ -522,6 +552,10 @@ public:
 		CachedData &segment = *n.m_segment;
 		bool is_cached_segment = (segment.m_cost >= 0);
 
+		/* Record the tiles of the segment if it is going to be stored in the global cache. */
+		const bool record_tiles = !is_cached_segment && Yapf().CanUseGlobalCache(n);
+		if (record_tiles) m_segment_tiles.clear();
+
 		int parent_cost = has_parent ? n.m_parent->m_cost : 0;
 
 		/* Each node cost contains 2 or 3 main components:
@@ -596,6 +630,7 @@ public:
 					/* We will need also some information about the last signal (if it was red). */
 					if (segment.m_last_signal_tile != INVALID_TILE) {
 						dbg_assert_tile(HasSignalOnTrackdir(segment.m_last_signal_tile, segment.m_last_signal_td), segment.m_last_signal_tile);
+						if (m_record_route_regions) RecordRouteRegions(segment.m_last_signal_tile, segment.m_last_signal_td, 0);
 						SignalState sig_state = GetSignalStateByTrackdir(segment.m_last_signal_tile, segment.m_last_signal_td);
 						bool is_red = (sig_state == SIGNAL_STATE_RED);
 						n.flags_u.flags_s.m_last_signal_was_red = is_red;
@@ -614,6 +649,9 @@ public:
 
 no_entry_cost: // jump here at the beginning if the node has no parent (it is the first node)
 
+			if (record_tiles) RecordSegmentTiles(*tf);
+			if (m_record_route_regions) RecordRouteRegions(cur.tile, cur.td, tf->m_tiles_skipped);
+
 			/* All other tile costs will be calculated here. */
 			segment_cost += Yapf().OneTileCost(cur.tile, cur.td);
 
@@ -648,6 +686,9 @@ no_entry_cost: // jump here at the beginning if the node has no parent (it is th
 					/* This waypoint is our destination; maybe this isn't an unreserved
 					 * one, so check that and if so see that as the last signal being
 					 * red. This way waypoints near stations should work better. */
+					/* The waiting position check reads vehicle occupancy, trace restrict programs and
+					 * tunnel/bridge signal states beyond the recorded regions, so the route cannot be cached. */
+					m_route_uncacheable = true;
 					CFollowTrackRail ft(v);
 					TileIndex t = cur.tile;
 					Trackdir td = cur.td;
@@ -828,6 +869,11 @@ no_entry_cost: // jump here at the beginning if the node has no parent (it is th
 			segment.m_end_segment_reason = end_segment_reason & ESRB_CACHED_MASK;
 			/* Save end of segment back to the node. */
 			n.SetLastTileTrackdir(cur.tile, cur.td);
+			if (record_tiles) {
+				/* The tile following the end of the segment also determines how the segment ends. */
+				RecordSegmentTiles(tf_local);
+				Yapf().PfNodeCacheSegmentTiles(n, m_segment_tiles);
+			}
 		}
 
 		/* Do we have an excuse why not to continue pathfinding in this direction? */
@@ -895,6 +941,11 @@ no_entry_cost: // jump here at the beginning if the node has no parent (it is th
 	{
 		m_disable_cache = disable;
 	}
+
+	inline bool IsCacheDisabled() const
+	{
+		return m_disable_cache;
+	}
 };
 
 #endif /* YAPF_COSTRAIL_HPP */
@@ -97,6 +97,8 @@ public:
 	/** Called by YAPF to detect if node ends in the desired destination */
 	inline bool PfDetectDestination(TileIndex tile, Trackdir td)
 	{
+		/* The waiting position check reads vehicle occupancy, which the route cache does not track */
+		Yapf().m_route_uncacheable = true;
 		return IsSafeWaitingPosition(Yapf().GetVehicle(), tile, td, true, !TrackFollower::Allow90degTurns()) &&
 				IsWaitingPositionFree(Yapf().GetVehicle(), tile, td, !TrackFollower::Allow90degTurns());
 	}
@@ -173,6 +175,11 @@ public:
 		CYapfDestinationRailBase::SetDestination(v);
 	}
 
+	inline TileIndex GetDestinationTile() const { return m_destTile; }
+	inline TrackdirBits GetDestinationTrackdirs() const { return m_destTrackdirs; }
+	inline StationID GetDestinationStationID() const { return m_dest_station_id; }
+	inline bool IsAnyDepotDestination() const { return m_any_depot; }
+
 	/** Called by YAPF to detect if node ends in the desired destination */
 	inline bool PfDetectDestination(Node &n)
 	{
@@ -15,6 +15,8 @@ struct CYapfRailSegmentKey
 {
 	uint32    m_value;
 
+	inline CYapfRailSegmentKey() : m_value(0) {}
+
 	inline CYapfRailSegmentKey(const CYapfNodeKeyTrackDir &node_key)
 	{
 		Set(node_key);
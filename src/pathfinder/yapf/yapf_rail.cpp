@@ -11,6 +11,7 @@
 
 #include "yapf.hpp"
 #include "yapf_cache.h"
+#include "../../rail_state_region.h"
 #include "yapf_node_rail.hpp"
 #include "yapf_costrail.hpp"
 #include "yapf_destrail.hpp"
@@ -18,6 +19,8 @@
 #include "../../newgrf_station.h"
 #include "../../tracerestrict.h"
 #include "../../debug.h"
+#include "../../settings_type.h"
+#include "../../3rdparty/cpp-btree/btree_map.h"
 
 #include "../../safeguards.h"
 
@@ -63,6 +66,134 @@ template <typename Tpf> void DumpState(Tpf &pf1, Tpf &pf2)
 	fclose(f2);
 }
 
+/**
+ * Cache of the results of rail pathfinder queries which do not reserve a path.
+ *
+ * A cached result is only returned when a new search would find the same result, so the
+ * cache contents do not need to be synchronised between network clients. Each entry records
+ * the version of every rail state region (see NotifyRailStateChange) in which the search
+ * read reservations or signal states, and is discarded when any of these has changed.
+ * Track layout, trace restrict program and pathfinder setting changes flush the whole cache.
+ * Searches which depended on trace restrict conditionals or on the occupancy of a
+ * complex waypoint are not cached.
+ */
+class CYapfRailRouteCache {
+public:
+	/** Inputs of a query which are not covered by the rail state regions. */
+	struct Key {
+		TileIndex origin_tile;
+		TileIndex dest_tile;
+		RailTypes railtypes;
+		StationID dest_station;
+		uint16 max_speed;
+		uint16 total_length;
+		Trackdir origin_td;
+		TrackdirBits dest_trackdirs;
+		Owner owner;
+		bool any_depot;
+
+		bool operator<(const Key &other) const
+		{
+			return std::tie(this->origin_tile, this->origin_td, this->dest_tile, this->dest_trackdirs, this->dest_station, this->any_depot, this->railtypes, this->owner, this->max_speed, this->total_length) <
+					std::tie(other.origin_tile, other.origin_td, other.dest_tile, other.dest_trackdirs, other.dest_station, other.any_depot, other.railtypes, other.owner, other.max_speed, other.total_length);
+		}
+	};
+
+	struct Entry {
+		std::vector<std::pair<uint, uint32>> regions; ///< rail state regions and their versions which the result depends on
+		uint32 node_expansions;                       ///< number of nodes expanded by the search
+		Trackdir next_trackdir;
+		bool path_found;
+	};
+
+	struct Stats {
+		uint64 hits = 0;             ///< number of lookups which returned a valid result
+		uint64 misses = 0;           ///< number of lookups which did not find an entry
+		uint64 invalidations = 0;    ///< number of entries discarded due to rail state changes
+		uint64 saved_expansions = 0; ///< number of node expansions avoided by cache hits
+	};
+
+	static const size_t MAX_ENTRIES = 16384; ///< flush the whole cache when it grows beyond this number of entries
+
+	static Stats s_stats[VEH_COMPANY_END];
+	static uint64 s_flushes;
+
+private:
+	btree::btree_map<Key, Entry> m_entries;
+	PathfinderSettings m_pf_settings; ///< pathfinder settings which the entries were calculated with
+
+	CYapfRailRouteCache()
+	{
+		memcpy(&this->m_pf_settings, &_settings_game.pf, sizeof(PathfinderSettings));
+	}
+
+public:
+	static CYapfRailRouteCache &Get()
+	{
+		static CYapfRailRouteCache cache;
+		return cache;
+	}
+
+	void Flush()
+	{
+		if (this->m_entries.empty()) return;
+		this->m_entries.clear();
+		s_flushes++;
+	}
+
+	const Entry *Lookup(const Key &key, VehicleType type)
+	{
+		if (memcmp(&this->m_pf_settings, &_settings_game.pf, sizeof(PathfinderSettings)) != 0) {
+			memcpy(&this->m_pf_settings, &_settings_game.pf, sizeof(PathfinderSettings));
+			this->Flush();
+		}
+
+		Stats &stats = s_stats[type];
+		auto iter = this->m_entries.find(key);
+		if (iter == this->m_entries.end()) {
+			stats.misses++;
+			return nullptr;
+		}
+		for (const auto &region : iter->second.regions) {
+			if (_rail_state_region_versions[region.first] != region.second) {
+				this->m_entries.erase(iter);
+				stats.invalidations++;
+				stats.misses++;
+				return nullptr;
+			}
+		}
+		stats.hits++;
+		stats.saved_expansions += iter->second.node_expansions;
+		return &iter->second;
+	}
+
+	void Store(const Key &key, std::vector<uint> &regions, Trackdir next_trackdir, bool path_found, uint32 node_expansions)
+	{
+		if (this->m_entries.size() >= MAX_ENTRIES) this->Flush();
+
+		std::sort(regions.begin(), regions.end());
+		regions.erase(std::unique(regions.begin(), regions.end()), regions.end());
+
+		Entry &entry = this->m_entries[key];
+		entry.regions.clear();
+		entry.regions.reserve(regions.size());
+		for (uint region : regions) {
+			entry.regions.emplace_back(region, _rail_state_region_versions[region]);
+		}
+		entry.node_expansions = node_expansions;
+		entry.next_trackdir = next_trackdir;
+		entry.path_found = path_found;
+	}
+
+	size_t Size() const
+	{
+		return this->m_entries.size();
+	}
+};
+
+CYapfRailRouteCache::Stats CYapfRailRouteCache::s_stats[VEH_COMPANY_END];
+uint64 CYapfRailRouteCache::s_flushes = 0;
+
 template <class Types>
 class CYapfReserveTrack
 {
@@ -135,6 +266,16 @@ private:
 		return tile != m_res_dest || td != m_res_dest_td;
 	}
 
+	/**
+	 * Notify the segment cost cache of a newly reserved track/platform.
+	 * The rail route cache is not flushed: the reservation already changed the version of the rail state region of the tile.
+	 */
+	bool NotifyReservedTileProc(TileIndex tile, Trackdir td)
+	{
+		CSegmentCostCacheBase::NotifyTrackLayoutChange(tile, TrackdirToTrack(td));
+		return tile != m_res_dest || td != m_res_dest_td;
+	}
+
 	/** Unreserve a single track/platform. Stops when the previous failer is reached. */
 	bool UnreserveSingleTrack(TileIndex tile, Trackdir td)
 	{
@@ -220,7 +361,10 @@ public:
 		if (target != nullptr) target->okay = true;
 
 		if (Yapf().CanUseGlobalCache(*m_res_node)) {
-			YapfNotifyTrackLayoutChange(INVALID_TILE, INVALID_TRACK);
+			/* Evict the cached segments along the newly reserved path. */
+			for (Node *node = m_res_node; node->m_parent != nullptr; node = node->m_parent) {
+				node->IterateTiles(Yapf().GetVehicle(), Yapf(), *this, &CYapfReserveTrack<Types>::NotifyReservedTileProc);
+			}
 		}
 
 		return true;
@@ -469,6 +613,8 @@ public:
 	typedef typename Types::NodeList::Titem Node;        ///< this will be our node type
 	typedef typename Node::Key Key;                      ///< key to hash tables
 
+	bool m_route_cache_hit = false;                      ///< the result of the last ChooseRailTrack() came from the route cache
+
 protected:
 	/** to access inherited path finder */
 	inline Tpf& Yapf()
@@ -526,12 +672,17 @@ public:
 			result1 = pf1.ChooseRailTrack(v, tile, enterdir, tracks, path_found, reserve_track, target, dest);
 		} else {
 			result1 = pf1.ChooseRailTrack(v, tile, enterdir, tracks, path_found, false, nullptr, nullptr);
+			const bool path_found1 = path_found;
 			Tpf pf2;
 			pf2.DisableCache(true);
 			Trackdir result2 = pf2.ChooseRailTrack(v, tile, enterdir, tracks, path_found, reserve_track, target, dest);
 			if (result1 != result2) {
-				DEBUG(desync, 0, "CACHE ERROR: ChooseRailTrack() = [%d, %d]", result1, result2);
+				DEBUG(desync, 0, "CACHE ERROR: ChooseRailTrack() = [%d, %d]%s", result1, result2, pf1.m_route_cache_hit ? " (route cache)" : "");
 				DumpState(pf1, pf2);
+			} else if (pf1.m_route_cache_hit) {
+				if (path_found1 != path_found) {
+					DEBUG(desync, 0, "CACHE ERROR: ChooseRailTrack() path found = [%d, %d] (route cache)", path_found1, path_found);
+				}
 			} else if (result1 != INVALID_TRACKDIR) {
 				CYapfFollowRailT::stDesyncCheck(pf1, pf2, "CACHE ERROR: ChooseRailTrack()", true);
 			}
@@ -550,6 +701,30 @@ public:
 		Yapf().SetOrigin(origin.tile, origin.trackdir, INVALID_TILE, INVALID_TRACKDIR, 1, true);
 		Yapf().SetDestination(v);
 
+		/* Searches which do not reserve have no side effects, so their results can be reused while the rail state they depend on is unchanged */
+		const bool use_route_cache = _settings_client.gui.yapf_rail_route_cache && !reserve_track && !Yapf().IsCacheDisabled();
+		CYapfRailRouteCache::Key route_key;
+		if (use_route_cache) {
+			route_key.origin_tile = origin.tile;
+			route_key.origin_td = origin.trackdir;
+			route_key.dest_tile = Yapf().GetDestinationTile();
+			route_key.dest_trackdirs = Yapf().GetDestinationTrackdirs();
+			route_key.dest_station = Yapf().GetDestinationStationID();
+			route_key.any_depot = Yapf().IsAnyDepotDestination();
+			route_key.railtypes = Yapf().GetCompatibleRailTypes();
+			route_key.owner = v->owner;
+			route_key.max_speed = std::min<int>(v->GetDisplayMaxSpeed(), v->current_order.GetMaxSpeed());
+			route_key.total_length = v->gcache.cached_total_length;
+
+			const CYapfRailRouteCache::Entry *entry = CYapfRailRouteCache::Get().Lookup(route_key, VEH_TRAIN);
+			if (entry != nullptr) {
+				m_route_cache_hit = true;
+				path_found = entry->path_found;
+				return entry->next_trackdir;
+			}
+			Yapf().m_record_route_regions = true;
+		}
+
 		/* find the best path */
 		path_found = Yapf().FindPath(v);
 
@@ -567,7 +742,8 @@ public:
 				pPrev = pNode;
 				pNode = pNode->m_parent;
 
-				this->FindSafePositionOnNode(pPrev);
+				/* The safe waiting positions are only used as reservation target, and depend on state which the route cache does not track */
+				if (reserve_track) this->FindSafePositionOnNode(pPrev);
 			}
 			/* return trackdir from the best origin node (one of start nodes) */
 			Node &best_next_node = *pPrev;
@@ -581,6 +757,10 @@ public:
 
 		/* Treat the path as found if stopped on the first two way signal(s). */
 		path_found |= Yapf().m_stopped_on_first_two_way_signal;
+
+		if (use_route_cache && !Yapf().m_route_uncacheable && !Yapf().IsCacheDisabled()) {
+			CYapfRailRouteCache::Get().Store(route_key, Yapf().m_route_regions, next_trackdir, path_found, Yapf().m_num_steps);
+		}
 		return next_trackdir;
 	}
 
@@ -781,12 +961,87 @@ bool YapfTrainFindNearestSafeTile(const Train *v, TileIndex tile, Trackdir td, b
 	return pfnFindNearestSafeTile(v, tile, td, override_railtype);
 }
 
-/** if any track changes, this counter is incremented - that will invalidate segment cost cache */
-int CSegmentCostCacheBase::s_rail_change_counter = 0;
+CSegmentCostCacheBase::Stats CSegmentCostCacheBase::s_stats;
+
+std::vector<CSegmentCostCacheBase *> &CSegmentCostCacheBase::Caches()
+{
+	static std::vector<CSegmentCostCacheBase *> caches;
+	return caches;
+}
+
+CSegmentCostCacheBase::CSegmentCostCacheBase() : m_pending_flush(false)
+{
+	Caches().push_back(this);
+}
+
+CSegmentCostCacheBase::~CSegmentCostCacheBase()
+{
+	auto &caches = Caches();
+	caches.erase(std::remove(caches.begin(), caches.end(), this), caches.end());
+}
+
+/**
+ * Queue a track layout change for all segment cost caches.
+ * @param tile The changed tile, or INVALID_TILE to flush the caches completely.
+ * @param track The changed track.
+ */
+void CSegmentCostCacheBase::NotifyTrackLayoutChange(TileIndex tile, Track track)
+{
+	for (CSegmentCostCacheBase *cache : Caches()) {
+		if (cache->m_pending_flush) continue;
+		if (tile == INVALID_TILE || cache->m_pending_tiles.size() >= C_MAX_PENDING_TILES) {
+			cache->m_pending_flush = true;
+			cache->m_pending_tiles.clear();
+		} else {
+			cache->m_pending_tiles.push_back(tile);
+		}
+	}
+}
+
+uint CSegmentCostCacheBase::TotalSize()
+{
+	uint size = 0;
+	for (const CSegmentCostCacheBase *cache : Caches()) {
+		size += cache->Size();
+	}
+	return size;
+}
 
 void YapfNotifyTrackLayoutChange(TileIndex tile, Track track)
 {
 	CSegmentCostCacheBase::NotifyTrackLayoutChange(tile, track);
+	YapfFlushRailRouteCache();
+}
+
+/** Discard all results in the rail route cache. */
+void YapfFlushRailRouteCache()
+{
+	CYapfRailRouteCache::Get().Flush();
+}
+
+void DumpYapfRailSegmentCacheStats(char *b, const char *last)
+{
+	const CSegmentCostCacheBase::Stats &stats = CSegmentCostCacheBase::s_stats;
+	const uint64 lookups = stats.hits + stats.misses;
+	b += seprintf(b, last, "Rail segment cost cache:\n");
+	b += seprintf(b, last, "  Segments: %u\n", CSegmentCostCacheBase::TotalSize());
+	b += seprintf(b, last, "  Hits:      " OTTD_PRINTF64U " (%.1f%%)\n", stats.hits, lookups > 0 ? (100.0 * stats.hits) / lookups : 0.0);
+	b += seprintf(b, last, "  Misses:    " OTTD_PRINTF64U "\n", stats.misses);
+	b += seprintf(b, last, "  Evictions: " OTTD_PRINTF64U "\n", stats.evictions);
+	b += seprintf(b, last, "  Flushes:   " OTTD_PRINTF64U "\n", stats.flushes);
+
+	static const char * const type_names[] = { "Train", "Road vehicle", "Ship", "Aircraft" };
+	static_assert(lengthof(type_names) == VEH_COMPANY_END);
+	b += seprintf(b, last, "\nRoute cache: %s\n", _settings_client.gui.yapf_rail_route_cache ? "enabled" : "disabled");
+	b += seprintf(b, last, "  Entries: " PRINTF_SIZE ", flushes: " OTTD_PRINTF64U "\n", CYapfRailRouteCache::Get().Size(), CYapfRailRouteCache::s_flushes);
+	for (uint type = 0; type < VEH_COMPANY_END; type++) {
+		const CYapfRailRouteCache::Stats &route_stats = CYapfRailRouteCache::s_stats[type];
+		const uint64 route_lookups = route_stats.hits + route_stats.misses;
+		if (route_lookups == 0 && type != VEH_TRAIN) continue;
+		b += seprintf(b, last, "  %s: hits: " OTTD_PRINTF64U " (%.1f%%), misses: " OTTD_PRINTF64U ", invalidations: " OTTD_PRINTF64U ", saved node expansions: " OTTD_PRINTF64U "\n",
+				type_names[type], route_stats.hits, route_lookups > 0 ? (100.0 * route_stats.hits) / route_lookups : 0.0,
+				route_stats.misses, route_stats.invalidations, route_stats.saved_expansions);
+	}
 }
 
 void YapfCheckRailSignalPenalties()
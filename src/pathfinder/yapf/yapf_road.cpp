@@ -12,6 +12,7 @@
 #include "yapf_node_road.hpp"
 #include "../../roadstop_base.h"
 #include "../../vehicle_func.h"
+#include "../../worker_thread.h"
 
 #include "../../safeguards.h"
 
@@ -26,6 +27,86 @@ const uint MAX_RV_PF_TILES = 1 << 11;
 
 const int MAX_RV_LEADER_TARGETS = 4;
 
+/**
+ * Get the occupancy of a road stop, as it is read by CYapfCostRoadT::OneTileCost.
+ * @param rs The road stop.
+ * @param dir The entry direction of a drive-through stop, or INVALID_DIAGDIR for the bays of a standard stop.
+ * @return The number of occupied units of the entry, or the bit set of occupied bays.
+ */
+static int GetRoadStopOccupancy(const RoadStop *rs, DiagDirection dir)
+{
+	if (dir == INVALID_DIAGDIR) return (rs->IsFreeBay(0) ? 0 : 1) | (rs->IsFreeBay(1) ? 0 : 2);
+	return rs->GetEntry(dir)->GetOccupied();
+}
+
+/** Road stop occupancy which was read by a search. */
+struct RoadStopOccupancyRead {
+	const RoadStop *rs; ///< The road stop.
+	DiagDirection dir;  ///< The entry direction, see GetRoadStopOccupancy.
+	int occupancy;      ///< The occupancy at the time of the search.
+};
+
+/**
+ * Path of a road vehicle which was searched ahead of the road vehicle tick loop, see YapfRoadVehiclePrefetchPaths.
+ * Besides the infrastructure, which does not change during the loop, the search reads the state of the vehicle,
+ * the occupancy of road stops and the vehicles in front of it. These are recorded, the result is only used
+ * when all of them are unchanged.
+ */
+struct RoadVehPrefetchedPath {
+	VehicleID veh;                   ///< The vehicle.
+	TileIndex tile;                  ///< The tile the vehicle is about to enter.
+	DiagDirection enterdir;          ///< The direction the vehicle enters the tile from.
+	bool used = false;               ///< Whether the result was already taken.
+
+	TileIndex veh_tile;              ///< The location of the vehicle.
+	TileIndex dest_tile;             ///< The destination tile of the vehicle.
+	RoadType roadtype;               ///< The road type of the vehicle.
+	int max_speed;                   ///< The maximum speed of the vehicle.
+	OrderType order_type;            ///< The type of the current order.
+	DestinationID order_dest;        ///< The destination of the current order.
+	DiagDirection order_travel_dir;  ///< The road vehicle travel direction of the current order.
+	uint16 order_max_speed;          ///< The maximum speed of the current order.
+	uint32 initial_layout_ctr;       ///< The road layout counter of the path cache before the search.
+	uint32 road_layout_ctr;          ///< The road layout change counter at the time of the search.
+
+	std::vector<RoadStopOccupancyRead> occupancy_reads;    ///< Road stop occupancy read by the search.
+	bool leader_targets_searched = false;                  ///< Whether the search looked for vehicles in front of the vehicle.
+	TileIndex leader_targets[MAX_RV_LEADER_TARGETS];       ///< The tiles targeted by the vehicles in front of the vehicle.
+
+	Trackdir trackdir;               ///< The result of the search.
+	bool path_found;                 ///< Whether a path was found.
+	RoadVehPathCache path_cache;     ///< The path cache after the search.
+
+	RoadVehPrefetchedPath(const YapfPathRequest &request)
+	{
+		const RoadVehicle *v = RoadVehicle::From(request.v);
+		this->veh = v->index;
+		this->tile = request.tile;
+		this->enterdir = request.enterdir;
+		this->veh_tile = v->tile;
+		this->dest_tile = v->dest_tile;
+		this->roadtype = v->roadtype;
+		this->max_speed = v->GetDisplayMaxSpeed();
+		this->order_type = v->current_order.GetType();
+		this->order_dest = v->current_order.GetDestination();
+		this->order_travel_dir = v->current_order.GetRoadVehTravelDirection();
+		this->order_max_speed = v->current_order.GetMaxSpeed();
+		this->initial_layout_ctr = v->path.layout_ctr;
+		this->road_layout_ctr = _road_layout_change_counter;
+		this->path_cache.layout_ctr = v->path.layout_ctr;
+	}
+
+	bool MatchesVehicle(const RoadVehicle *v, const RoadVehPathCache &path_cache) const
+	{
+		return this->veh_tile == v->tile && this->dest_tile == v->dest_tile && this->roadtype == v->roadtype &&
+				this->max_speed == v->GetDisplayMaxSpeed() && this->order_type == v->current_order.GetType() &&
+				this->order_dest == v->current_order.GetDestination() && this->order_travel_dir == v->current_order.GetRoadVehTravelDirection() &&
+				this->order_max_speed == v->current_order.GetMaxSpeed() && path_cache.empty() && this->initial_layout_ctr == path_cache.layout_ctr;
+	}
+};
+
+static std::vector<RoadVehPrefetchedPath> _road_prefetched_paths; ///< Prefetched paths of the current tick, sorted by vehicle.
+
 template <class Types>
 class CYapfCostRoadT
 {
@@ -67,6 +148,12 @@ protected:
 		return 0;
 	}
 
+	/** Record road stop occupancy which was read by a prefetched search, see RoadVehPrefetchedPath. */
+	inline void RecordOccupancyRead(const RoadStop *rs, DiagDirection dir)
+	{
+		if (Yapf().m_prefetch != nullptr) Yapf().m_prefetch->occupancy_reads.push_back({ rs, dir, GetRoadStopOccupancy(rs, dir) });
+	}
+
 	/** return one tile cost */
 	inline int OneTileCost(TileIndex tile, Trackdir trackdir, const TrackFollower *tf)
 	{
@@ -105,9 +192,11 @@ protected:
 							const RoadStop::Entry *entry = rs->GetEntry(dir);
 							if (GetDriveThroughStopDisallowedRoadDirections(tile) != DRD_NONE && !tf->IsTram()) {
 								cost += (entry->GetOccupied() + rs->GetEntry(ReverseDiagDir(dir))->GetOccupied()) * Yapf().PfGetSettings().road_stop_occupied_penalty / (2 * entry->GetLength());
+								RecordOccupancyRead(rs, ReverseDiagDir(dir));
 							} else {
 								cost += entry->GetOccupied() * Yapf().PfGetSettings().road_stop_occupied_penalty / entry->GetLength();
 							}
+							RecordOccupancyRead(rs, dir);
 						}
 
 						if (predicted_occupied) {
@@ -116,6 +205,7 @@ protected:
 					} else {
 						/* Increase cost for filled road stops */
 						cost += Yapf().PfGetSettings().road_stop_bay_occupied_penalty * (!rs->IsFreeBay(0) + !rs->IsFreeBay(1)) / 2;
+						RecordOccupancyRead(rs, INVALID_DIAGDIR);
 						if (predicted_occupied) {
 							cost += Yapf().PfGetSettings().road_stop_bay_occupied_penalty;
 						}
@@ -399,6 +489,23 @@ static Vehicle * FindVehiclesOnTileProc(Vehicle *v, void *_data)
 	return nullptr;
 }
 
+/**
+ * Find the tiles targeted by the vehicles on a tile which head to the same station as a vehicle.
+ * @param v The vehicle.
+ * @param tile The tile.
+ * @param targets [out] The targeted tiles, terminated by INVALID_TILE when not all are used.
+ */
+static void FindLeaderTargets(const RoadVehicle *v, TileIndex tile, TileIndex (&targets)[MAX_RV_LEADER_TARGETS])
+{
+	for (int i = 0; i < MAX_RV_LEADER_TARGETS; ++i) {
+		targets[i] = INVALID_TILE;
+	}
+	FindVehiclesOnTileProcData data;
+	data.origin_vehicle = v;
+	data.targets = &targets;
+	FindVehicleOnPos(tile, VEH_ROAD, &data, &FindVehiclesOnTileProc);
+}
+
 template <class Types>
 class CYapfFollowRoadT
 {
@@ -442,6 +549,13 @@ public:
 		return pf.ChooseRoadTrack(v, tile, enterdir, path_found, path_cache);
 	}
 
+	static void stPrefetchRoadTrack(const RoadVehicle *v, RoadVehPrefetchedPath &prefetch)
+	{
+		Tpf pf;
+		pf.m_prefetch = &prefetch;
+		prefetch.trackdir = pf.ChooseRoadTrack(v, prefetch.tile, prefetch.enterdir, prefetch.path_found, prefetch.path_cache);
+	}
+
 	inline Trackdir ChooseRoadTrack(const RoadVehicle *v, TileIndex tile, DiagDirection enterdir, bool &path_found, RoadVehPathCache &path_cache)
 	{
 		/* Handle special case - when next tile is destination tile.
@@ -479,13 +593,11 @@ public:
 		if (multiple_targets && non_cached_area.Contains(tile)) {
 			/* Destination station has at least 2 usable road stops, or first is a drive-through stop,
 			 * check for other vehicles headin to the same destination directly in front */
-			for (int i = 1; i < MAX_RV_LEADER_TARGETS; ++i) {
-				Yapf().leader_targets[i] = INVALID_TILE;
+			FindLeaderTargets(v, tile, Yapf().leader_targets);
+			if (Yapf().m_prefetch != nullptr) {
+				Yapf().m_prefetch->leader_targets_searched = true;
+				std::copy(std::begin(Yapf().leader_targets), std::end(Yapf().leader_targets), Yapf().m_prefetch->leader_targets);
 			}
-			FindVehiclesOnTileProcData data;
-			data.origin_vehicle = v;
-			data.targets = &Yapf().leader_targets;
-			FindVehicleOnPos(tile, VEH_ROAD, &data, &FindVehiclesOnTileProc);
 		}
 
 		/* find the best path */
@@ -630,6 +742,7 @@ struct CYapfRoad_TypesT
 template <class Types>
 struct CYapfRoadCommon : CYapfT<Types> {
 	TileIndex leader_targets[MAX_RV_LEADER_TARGETS]; ///< the tiles targeted by vehicles in front of the current vehicle
+	RoadVehPrefetchedPath *m_prefetch = nullptr;     ///< the prefetched path which records the state read by the search, if any
 };
 
 struct CYapfRoad1         : CYapfRoadCommon<CYapfRoad_TypesT<CYapfRoad1        , CRoadNodeListTrackDir, CYapfDestinationTileRoadT    > > {};
@@ -639,8 +752,77 @@ struct CYapfRoadAnyDepot1 : CYapfRoadCommon<CYapfRoad_TypesT<CYapfRoadAnyDepot1,
 struct CYapfRoadAnyDepot2 : CYapfRoadCommon<CYapfRoad_TypesT<CYapfRoadAnyDepot2, CRoadNodeListExitDir , CYapfDestinationAnyDepotRoadT> > {};
 
 
+/**
+ * Find the prefetched path of a road vehicle, if it is still valid.
+ * @param v The vehicle.
+ * @param tile The tile the vehicle is about to enter.
+ * @param enterdir The direction the vehicle enters the tile from.
+ * @param path_cache The path cache of the vehicle.
+ * @return The prefetched path, or nullptr if there is none or the state read by its search changed.
+ */
+static RoadVehPrefetchedPath *FindRoadVehPrefetchedPath(const RoadVehicle *v, TileIndex tile, DiagDirection enterdir, const RoadVehPathCache &path_cache)
+{
+	auto it = std::lower_bound(_road_prefetched_paths.begin(), _road_prefetched_paths.end(), v->index, [](const RoadVehPrefetchedPath &prefetch, VehicleID veh) {
+		return prefetch.veh < veh;
+	});
+	if (it == _road_prefetched_paths.end() || it->veh != v->index || it->used) return nullptr;
+
+	RoadVehPrefetchedPath &prefetch = *it;
+	if (prefetch.tile != tile || prefetch.enterdir != enterdir || !prefetch.MatchesVehicle(v, path_cache)) return nullptr;
+	if (prefetch.road_layout_ctr != _road_layout_change_counter) return nullptr;
+	for (const RoadStopOccupancyRead &read : prefetch.occupancy_reads) {
+		if (GetRoadStopOccupancy(read.rs, read.dir) != read.occupancy) return nullptr;
+	}
+	if (prefetch.leader_targets_searched) {
+		TileIndex leader_targets[MAX_RV_LEADER_TARGETS];
+		FindLeaderTargets(v, tile, leader_targets);
+		if (!std::equal(std::begin(leader_targets), std::end(leader_targets), prefetch.leader_targets)) return nullptr;
+	}
+	prefetch.used = true;
+	return &prefetch;
+}
+
+void YapfRoadVehiclePrefetchPaths(std::vector<YapfPathRequest> &requests)
+{
+	std::sort(requests.begin(), requests.end(), [](const YapfPathRequest &a, const YapfPathRequest &b) {
+		return a.v->index < b.v->index;
+	});
+
+	_road_prefetched_paths.clear();
+	_road_prefetched_paths.reserve(requests.size());
+	for (const YapfPathRequest &request : requests) {
+		_road_prefetched_paths.emplace_back(request);
+	}
+
+	typedef void (*PfnPrefetchRoadTrack)(const RoadVehicle*, RoadVehPrefetchedPath &prefetch);
+	PfnPrefetchRoadTrack pfnPrefetchRoadTrack = &CYapfRoad2::stPrefetchRoadTrack;
+	if (_settings_game.pf.yapf.disable_node_optimization) {
+		pfnPrefetchRoadTrack = &CYapfRoad1::stPrefetchRoadTrack;
+	}
+
+	_general_worker_pool.ParallelFor(0, requests.size(), 1, [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) {
+			pfnPrefetchRoadTrack(RoadVehicle::From(requests[i].v), _road_prefetched_paths[i]);
+		}
+	});
+}
+
+void YapfRoadVehicleDiscardPrefetchedPaths()
+{
+	_road_prefetched_paths.clear();
+}
+
 Trackdir YapfRoadVehicleChooseTrack(const RoadVehicle *v, TileIndex tile, DiagDirection enterdir, TrackdirBits trackdirs, bool &path_found, RoadVehPathCache &path_cache)
 {
+	if (!_road_prefetched_paths.empty()) {
+		const RoadVehPrefetchedPath *prefetch = FindRoadVehPrefetchedPath(v, tile, enterdir, path_cache);
+		if (prefetch != nullptr) {
+			path_found = prefetch->path_found;
+			path_cache = prefetch->path_cache;
+			return (prefetch->trackdir != INVALID_TRACKDIR) ? prefetch->trackdir : (Trackdir)FindFirstBit2x64(trackdirs);
+		}
+	}
+
 	/* default is YAPF type 2 */
 	typedef Trackdir (*PfnChooseRoadTrack)(const RoadVehicle*, TileIndex, DiagDirection, bool &path_found, RoadVehPathCache &path_cache);
 	PfnChooseRoadTrack pfnChooseRoadTrack = &CYapfRoad2::stChooseRoadTrack; // default: ExitDir, allow 90-deg
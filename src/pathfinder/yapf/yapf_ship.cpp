@@ -11,12 +11,85 @@
 #include "../../ship.h"
 #include "../../industry.h"
 #include "../../vehicle_func.h"
+#include "../../worker_thread.h"
 
 #include "yapf.hpp"
 #include "yapf_node_ship.hpp"
 
 #include "../../safeguards.h"
 
+/**
+ * Path of a ship which was searched ahead of the ship tick loop, see YapfShipPrefetchPaths.
+ * Besides the infrastructure, which does not change during the loop, the search reads the state of the ship
+ * and the number of ships on docking tiles. These are recorded, the result is only used when all of them
+ * are unchanged.
+ */
+struct ShipPrefetchedPath {
+	VehicleID veh;                   ///< The ship.
+	TileIndex tile;                  ///< The tile the ship is about to enter.
+	DiagDirection enterdir;          ///< The direction the ship enters the tile from.
+	TrackBits tracks;                ///< The available tracks on the tile.
+	bool used = false;               ///< Whether the result was already taken.
+
+	TileIndex veh_tile;              ///< The location of the ship.
+	Direction direction;             ///< The direction of the ship.
+	TrackBits state;                 ///< The track of the ship.
+	TileIndex dest_tile;             ///< The destination tile of the ship.
+	OrderType order_type;            ///< The type of the current order.
+	DestinationID order_dest;        ///< The destination of the current order.
+
+	std::vector<std::pair<TileIndex, uint>> docking_reads; ///< Docking tiles and the number of ships on them, read by the search.
+
+	Trackdir trackdir;               ///< The result of the search.
+	bool path_found;                 ///< Whether a path was found.
+	ShipPathCache path_cache;        ///< The path cache after the search.
+
+	ShipPrefetchedPath(const YapfPathRequest &request)
+	{
+		const Ship *v = Ship::From(request.v);
+		this->veh = v->index;
+		this->tile = request.tile;
+		this->enterdir = request.enterdir;
+		this->tracks = request.tracks;
+		this->veh_tile = v->tile;
+		this->direction = v->direction;
+		this->state = v->state;
+		this->dest_tile = v->dest_tile;
+		this->order_type = v->current_order.GetType();
+		this->order_dest = v->current_order.GetDestination();
+	}
+
+	bool MatchesVehicle(const Ship *v, const ShipPathCache &path_cache) const
+	{
+		return this->veh_tile == v->tile && this->direction == v->direction && this->state == v->state && this->dest_tile == v->dest_tile &&
+				this->order_type == v->current_order.GetType() && this->order_dest == v->current_order.GetDestination() && path_cache.empty();
+	}
+};
+
+static std::vector<ShipPrefetchedPath> _ship_prefetched_paths; ///< Prefetched paths of the current tick, sorted by vehicle.
+
+/** Count the ships on a tile, ignoring ships inside depots. */
+static Vehicle *CountShipProc(Vehicle *v, void *data)
+{
+	uint *count = (uint *)data;
+	/* Ignore other vehicles (aircraft) and ships inside depot. */
+	if ((v->vehstatus & VS_HIDDEN) == 0) (*count)++;
+
+	return nullptr;
+}
+
+/**
+ * Get the number of ships on a docking tile, as it is read by CYapfCostShipT::PfCalcCost.
+ * @param tile The docking tile.
+ * @return The number of ships.
+ */
+static uint GetDockingTileShipCount(TileIndex tile)
+{
+	uint count = 0;
+	HasVehicleOnPos(tile, VEH_SHIP, &count, &CountShipProc);
+	return count;
+}
+
 template <class Types>
 class CYapfDestinationTileWaterT
 {
@@ -136,7 +209,7 @@ public:
 		return 'w';
 	}
 
-	static Trackdir ChooseShipTrack(const Ship *v, TileIndex tile, DiagDirection enterdir, TrackBits tracks, bool &path_found, ShipPathCache &path_cache)
+	static Trackdir ChooseShipTrack(const Ship *v, TileIndex tile, DiagDirection enterdir, TrackBits tracks, bool &path_found, ShipPathCache &path_cache, ShipPrefetchedPath *prefetch)
 	{
 		/* handle special case - when next tile is destination tile */
 		if (tile == v->dest_tile) {
@@ -160,6 +233,7 @@ public:
 
 		/* create pathfinder instance */
 		Tpf pf;
+		pf.m_prefetch = prefetch;
 		/* set origin and destination nodes */
 		pf.SetOrigin(src_tile, trackdirs);
 		pf.SetDestination(v);
@@ -275,14 +349,7 @@ public:
 		return 0;
 	}
 
-	static Vehicle *CountShipProc(Vehicle *v, void *data)
-	{
-		uint *count = (uint *)data;
-		/* Ignore other vehicles (aircraft) and ships inside depot. */
-		if ((v->vehstatus & VS_HIDDEN) == 0) (*count)++;
-
-		return nullptr;
-	}
+	ShipPrefetchedPath *m_prefetch = nullptr; ///< the prefetched path which records the state read by the search, if any
 
 	/**
 	 * Called by YAPF to calculate the cost from the origin to the given node.
@@ -298,9 +365,9 @@ public:
 
 		if (IsDockingTile(n.GetTile())) {
 			/* Check docking tile for occupancy */
-			uint count = 0;
-			HasVehicleOnPos(n.GetTile(), VEH_SHIP, &count, &CountShipProc);
+			uint count = GetDockingTileShipCount(n.GetTile());
 			c += count * 3 * YAPF_TILE_LENGTH;
+			if (m_prefetch != nullptr) m_prefetch->docking_reads.emplace_back(n.GetTile(), count);
 		}
 
 		/* Skipped tile cost for aqueducts. */
@@ -348,19 +415,83 @@ struct CYapfShip1 : CYapfT<CYapfShip_TypesT<CYapfShip1, CFollowTrackWater    , C
 /* YAPF type 2 - uses TileIndex/DiagDirection as Node key */
 struct CYapfShip2 : CYapfT<CYapfShip_TypesT<CYapfShip2, CFollowTrackWater    , CShipNodeListExitDir > > {};
 
-/** Ship controller helper - path finder invoker */
-Track YapfShipChooseTrack(const Ship *v, TileIndex tile, DiagDirection enterdir, TrackBits tracks, bool &path_found, ShipPathCache &path_cache)
+typedef Trackdir (*PfnChooseShipTrack)(const Ship*, TileIndex, DiagDirection, TrackBits, bool &path_found, ShipPathCache &path_cache, ShipPrefetchedPath *prefetch);
+
+static PfnChooseShipTrack GetChooseShipTrackFunc()
 {
 	/* default is YAPF type 2 */
-	typedef Trackdir (*PfnChooseShipTrack)(const Ship*, TileIndex, DiagDirection, TrackBits, bool &path_found, ShipPathCache &path_cache);
 	PfnChooseShipTrack pfnChooseShipTrack = CYapfShip2::ChooseShipTrack; // default: ExitDir
 
 	/* check if non-default YAPF type needed */
 	if (_settings_game.pf.yapf.disable_node_optimization) {
 		pfnChooseShipTrack = &CYapfShip1::ChooseShipTrack; // Trackdir
 	}
+	return pfnChooseShipTrack;
+}
+
+/**
+ * Find the prefetched path of a ship, if it is still valid.
+ * @param v The ship.
+ * @param tile The tile the ship is about to enter.
+ * @param enterdir The direction the ship enters the tile from.
+ * @param tracks The available tracks on the tile.
+ * @param path_cache The path cache of the ship.
+ * @return The prefetched path, or nullptr if there is none or the state read by its search changed.
+ */
+static ShipPrefetchedPath *FindShipPrefetchedPath(const Ship *v, TileIndex tile, DiagDirection enterdir, TrackBits tracks, const ShipPathCache &path_cache)
+{
+	auto it = std::lower_bound(_ship_prefetched_paths.begin(), _ship_prefetched_paths.end(), v->index, [](const ShipPrefetchedPath &prefetch, VehicleID veh) {
+		return prefetch.veh < veh;
+	});
+	if (it == _ship_prefetched_paths.end() || it->veh != v->index || it->used) return nullptr;
+
+	ShipPrefetchedPath &prefetch = *it;
+	if (prefetch.tile != tile || prefetch.enterdir != enterdir || prefetch.tracks != tracks || !prefetch.MatchesVehicle(v, path_cache)) return nullptr;
+	for (const auto &read : prefetch.docking_reads) {
+		if (GetDockingTileShipCount(read.first) != read.second) return nullptr;
+	}
+	prefetch.used = true;
+	return &prefetch;
+}
+
+void YapfShipPrefetchPaths(std::vector<YapfPathRequest> &requests)
+{
+	std::sort(requests.begin(), requests.end(), [](const YapfPathRequest &a, const YapfPathRequest &b) {
+		return a.v->index < b.v->index;
+	});
+
+	_ship_prefetched_paths.clear();
+	_ship_prefetched_paths.reserve(requests.size());
+	for (const YapfPathRequest &request : requests) {
+		_ship_prefetched_paths.emplace_back(request);
+	}
+
+	PfnChooseShipTrack pfnChooseShipTrack = GetChooseShipTrackFunc();
+	_general_worker_pool.ParallelFor(0, requests.size(), 1, [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) {
+			ShipPrefetchedPath &prefetch = _ship_prefetched_paths[i];
+			prefetch.trackdir = pfnChooseShipTrack(Ship::From(requests[i].v), prefetch.tile, prefetch.enterdir, prefetch.tracks, prefetch.path_found, prefetch.path_cache, &prefetch);
+		}
+	});
+}
 
-	Trackdir td_ret = pfnChooseShipTrack(v, tile, enterdir, tracks, path_found, path_cache);
+void YapfShipDiscardPrefetchedPaths()
+{
+	_ship_prefetched_paths.clear();
+}
+
+/** Ship controller helper - path finder invoker */
+Track YapfShipChooseTrack(const Ship *v, TileIndex tile, DiagDirection enterdir, TrackBits tracks, bool &path_found, ShipPathCache &path_cache)
+{
+	Trackdir td_ret;
+	const ShipPrefetchedPath *prefetch = _ship_prefetched_paths.empty() ? nullptr : FindShipPrefetchedPath(v, tile, enterdir, tracks, path_cache);
+	if (prefetch != nullptr) {
+		path_found = prefetch->path_found;
+		path_cache = prefetch->path_cache;
+		td_ret = prefetch->trackdir;
+	} else {
+		td_ret = GetChooseShipTrackFunc()(v, tile, enterdir, tracks, path_found, path_cache, nullptr);
+	}
 	return (td_ret != INVALID_TRACKDIR) ? TrackdirToTrack(td_ret) : INVALID_TRACK;
 }
 
@@ -0,0 +1,309 @@
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file yapf_stats.cpp Statistics of the YAPF searches, per vehicle type. */
+
+#include "../../stdafx.h"
+#include "yapf_stats.h"
+#include "yapf.h"
+#include "nodelist.hpp"
+#include "../../framerate_type.h"
+#include "../../string_func.h"
+#include "../../core/bitmath_func.hpp"
+#include "../../train.h"
+#include "../../roadveh.h"
+#include "../../ship.h"
+#include "../../depot_map.h"
+#include "../../settings_type.h"
+#include <chrono>
+#include <mutex>
+#include <random>
+
+#include "../../safeguards.h"
+
+bool _yapf_node_list_pool_disabled = false; ///< Allocate the node list storage for every search instead of reusing it, for benchmarking.
+
+static YapfSearchStats _yapf_search_stats[VEH_COMPANY_END];
+static uint64 _yapf_search_tick_ns[VEH_COMPANY_END]; ///< time spent searching in the current tick, fed to the framerate window
+
+/** Framerate window element of each vehicle type, aircraft do not use YAPF. */
+static const PerformanceElement _yapf_search_pfe[VEH_COMPANY_END] = { PFE_GL_PF_TRAINS, PFE_GL_PF_ROADVEHS, PFE_GL_PF_SHIPS, PFE_MAX };
+static const char * const _yapf_search_type_names[VEH_COMPANY_END] = { "train", "road_vehicle", "ship", "aircraft" };
+
+void YapfStatsHistogram::Add(uint64 value)
+{
+	uint bucket = (value == 0) ? 0 : FindLastBit(value) + 1;
+	this->buckets[std::min<uint>(bucket, BUCKETS - 1)]++;
+}
+
+/**
+ * Get the range of values counted by a histogram bucket.
+ * @param bucket The bucket.
+ * @return The lowest and highest value, UINT64_MAX when the bucket is unbounded.
+ */
+static std::pair<uint64, uint64> GetHistogramBucketRange(uint bucket)
+{
+	if (bucket == 0) return { 0, 0 };
+	const uint64 low = (uint64)1 << (bucket - 1);
+	if (bucket == YapfStatsHistogram::BUCKETS - 1) return { low, UINT64_MAX };
+	return { low, (low << 1) - 1 };
+}
+
+/**
+ * Record the measurements of a single search.
+ * @param type Vehicle type of the search.
+ * @param veh The vehicle which is searching.
+ * @param tile Location of the vehicle.
+ * @param record The measurements.
+ */
+void RecordYapfSearch(VehicleType type, VehicleID veh, TileIndex tile, const YapfSearchRecord &record)
+{
+	/* Searches may run on worker threads, see YapfRoadVehiclePrefetchPaths and YapfShipPrefetchPaths. */
+	static std::mutex lock;
+	std::lock_guard<std::mutex> guard(lock);
+
+	YapfSearchStats &stats = _yapf_search_stats[type];
+	stats.searches++;
+	if (record.path_found) stats.paths_found++;
+	if (record.cutoff) stats.cutoffs++;
+	stats.nodes_opened += record.nodes_opened;
+	stats.nodes_closed += record.nodes_closed;
+	stats.cost_calcs += record.cost_calcs;
+	stats.cache_hits += record.cache_hits;
+	stats.total_ns += record.ns;
+	stats.opened_histogram.Add(record.nodes_opened);
+	stats.closed_histogram.Add(record.nodes_closed);
+	stats.latency_histogram.Add(record.ns / 1000);
+	if (record.ns > stats.slowest_ns) {
+		stats.slowest_ns = record.ns;
+		stats.slowest_nodes = record.nodes_opened;
+		stats.slowest_vehicle = veh;
+		stats.slowest_tile = tile;
+	}
+	_yapf_search_tick_ns[type] += record.ns;
+}
+
+/**
+ * Start a new game tick for the search statistics.
+ * This feeds the time spent searching in the previous tick to the framerate window.
+ * @param paused Whether the game loop is paused this tick.
+ */
+void YapfStatsBeginTick(bool paused)
+{
+	for (uint type = 0; type < VEH_COMPANY_END; type++) {
+		const PerformanceElement pfe = _yapf_search_pfe[type];
+		if (pfe == PFE_MAX) continue;
+		if (paused) {
+			PerformanceMeasurer::Paused(pfe);
+		} else {
+			PerformanceAccumulator::AddNanoseconds(pfe, _yapf_search_tick_ns[type]);
+			PerformanceAccumulator::Reset(pfe);
+			_yapf_search_tick_ns[type] = 0;
+		}
+	}
+}
+
+void ResetYapfSearchStats()
+{
+	for (YapfSearchStats &stats : _yapf_search_stats) {
+		stats = {};
+	}
+}
+
+static char *DumpYapfStatsHistogram(char *b, const char *last, const char *name, const YapfStatsHistogram &histogram)
+{
+	b += seprintf(b, last, "    %s:", name);
+	for (uint bucket = 0; bucket < YapfStatsHistogram::BUCKETS; bucket++) {
+		if (histogram.buckets[bucket] == 0) continue;
+		const auto range = GetHistogramBucketRange(bucket);
+		if (range.second == UINT64_MAX) {
+			b += seprintf(b, last, " >=" OTTD_PRINTF64U ": " OTTD_PRINTF64U, range.first, histogram.buckets[bucket]);
+		} else if (range.first == range.second) {
+			b += seprintf(b, last, " " OTTD_PRINTF64U ": " OTTD_PRINTF64U, range.first, histogram.buckets[bucket]);
+		} else {
+			b += seprintf(b, last, " " OTTD_PRINTF64U "-" OTTD_PRINTF64U ": " OTTD_PRINTF64U, range.first, range.second, histogram.buckets[bucket]);
+		}
+	}
+	b += seprintf(b, last, "\n");
+	return b;
+}
+
+char *DumpYapfSearchStats(char *b, const char *last)
+{
+	bool any = false;
+	for (uint type = 0; type < VEH_COMPANY_END; type++) {
+		const YapfSearchStats &stats = _yapf_search_stats[type];
+		if (stats.searches == 0) continue;
+		any = true;
+
+		const double searches = (double)stats.searches;
+		b += seprintf(b, last, "%s: " OTTD_PRINTF64U " searches, " OTTD_PRINTF64U " paths found (%.1f%%), " OTTD_PRINTF64U " max_search_nodes cutoffs (%.1f%%)\n",
+				_yapf_search_type_names[type], stats.searches, stats.paths_found, (100.0 * stats.paths_found) / searches, stats.cutoffs, (100.0 * stats.cutoffs) / searches);
+		const uint64 costs = stats.cost_calcs + stats.cache_hits;
+		b += seprintf(b, last, "  Nodes: opened: " OTTD_PRINTF64U " (%.1f avg), closed: " OTTD_PRINTF64U " (%.1f avg), segment cache hits: %.1f%%\n",
+				stats.nodes_opened, stats.nodes_opened / searches, stats.nodes_closed, stats.nodes_closed / searches, costs > 0 ? (100.0 * stats.cache_hits) / costs : 0.0);
+		b += seprintf(b, last, "  Time: total: %.3f ms, avg: %.1f us, slowest: %.1f us (vehicle %u at tile 0x%X, %u nodes opened)\n",
+				stats.total_ns / 1000000.0, stats.total_ns / searches / 1000.0, stats.slowest_ns / 1000.0, stats.slowest_vehicle, stats.slowest_tile, stats.slowest_nodes);
+		b = DumpYapfStatsHistogram(b, last, "Nodes opened", stats.opened_histogram);
+		b = DumpYapfStatsHistogram(b, last, "Nodes closed", stats.closed_histogram);
+		b = DumpYapfStatsHistogram(b, last, "Time (us)", stats.latency_histogram);
+	}
+	if (!any) b += seprintf(b, last, "No searches recorded\n");
+	return b;
+}
+
+char *DumpYapfSearchStatsCsv(char *b, const char *last)
+{
+	b += seprintf(b, last, "vehicle_type,metric,min,max,value\n");
+	for (uint type = 0; type < VEH_COMPANY_END; type++) {
+		const YapfSearchStats &stats = _yapf_search_stats[type];
+		if (stats.searches == 0) continue;
+
+		const char *name = _yapf_search_type_names[type];
+		b += seprintf(b, last, "%s,searches,,," OTTD_PRINTF64U "\n", name, stats.searches);
+		b += seprintf(b, last, "%s,paths_found,,," OTTD_PRINTF64U "\n", name, stats.paths_found);
+		b += seprintf(b, last, "%s,cutoffs,,," OTTD_PRINTF64U "\n", name, stats.cutoffs);
+		b += seprintf(b, last, "%s,nodes_opened,,," OTTD_PRINTF64U "\n", name, stats.nodes_opened);
+		b += seprintf(b, last, "%s,nodes_closed,,," OTTD_PRINTF64U "\n", name, stats.nodes_closed);
+		b += seprintf(b, last, "%s,cost_calcs,,," OTTD_PRINTF64U "\n", name, stats.cost_calcs);
+		b += seprintf(b, last, "%s,cache_hits,,," OTTD_PRINTF64U "\n", name, stats.cache_hits);
+		b += seprintf(b, last, "%s,total_ns,,," OTTD_PRINTF64U "\n", name, stats.total_ns);
+
+		auto dump_histogram = [&](const char *metric, const YapfStatsHistogram &histogram) {
+			for (uint bucket = 0; bucket < YapfStatsHistogram::BUCKETS; bucket++) {
+				const auto range = GetHistogramBucketRange(bucket);
+				if (range.second == UINT64_MAX) {
+					b += seprintf(b, last, "%s,%s," OTTD_PRINTF64U ",," OTTD_PRINTF64U "\n", name, metric, range.first, histogram.buckets[bucket]);
+				} else {
+					b += seprintf(b, last, "%s,%s," OTTD_PRINTF64U "," OTTD_PRINTF64U "," OTTD_PRINTF64U "\n", name, metric, range.first, range.second, histogram.buckets[bucket]);
+				}
+			}
+		};
+		dump_histogram("nodes_opened_histogram", stats.opened_histogram);
+		dump_histogram("nodes_closed_histogram", stats.closed_histogram);
+		dump_histogram("time_us_histogram", stats.latency_histogram);
+	}
+	return b;
+}
+
+/** Item of the synthetic heap benchmark, ordered by cost like the pathfinder nodes. */
+struct YapfHeapBenchmarkItem {
+	int cost;
+
+	inline bool operator<(const YapfHeapBenchmarkItem &other) const
+	{
+		return this->cost < other.cost;
+	}
+};
+
+/**
+ * Run an A-star like sequence of inserts and removals of the best item on a priority queue.
+ * @param items Storage of the items.
+ * @param checksum Set to a checksum of the costs of the removed items.
+ * @return Duration in microseconds.
+ */
+template <class Tqueue>
+static uint64 TimeBenchmarkYapfHeap(std::vector<YapfHeapBenchmarkItem> &items, uint64 &checksum)
+{
+	std::mt19937 rng(0x59415046);
+	std::uniform_int_distribution<int> step(100, 1500);
+	Tqueue queue(2048);
+	checksum = 0;
+
+	auto start = std::chrono::steady_clock::now();
+	size_t next = 0;
+	items[next].cost = 0;
+	queue.Include(&items[next++]);
+	while (!queue.IsEmpty()) {
+		const YapfHeapBenchmarkItem *best = queue.Shift();
+		checksum = checksum * 31 + best->cost;
+		/* expand to up to three neighbours, with a cost increasing like segment costs */
+		for (uint i = 0; i < 3 && next < items.size(); i++) {
+			items[next].cost = best->cost + step(rng);
+			queue.Include(&items[next++]);
+		}
+	}
+	return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * Benchmark the YAPF searches on the vehicles of the current game, with the node list storage
+ * allocated for every search and reused from the per thread pool.
+ * The searches are the side effect free nearest depot and reverse checks, the results are not used.
+ * Also compare the binary and 4-ary heap on a synthetic A-star like workload.
+ * @param b buffer
+ * @param last last byte of buffer
+ * @param iterations number of times to repeat the searches
+ * @return updated buffer
+ */
+char *BenchmarkYapfSearches(char *b, const char *last, uint iterations)
+{
+	iterations = std::max<uint>(iterations, 1);
+
+	auto run_searches = [&](VehicleType type) -> uint {
+		uint searches = 0;
+		for (uint i = 0; i < iterations; i++) {
+			switch (type) {
+				case VEH_TRAIN:
+					if (_settings_game.pf.pathfinder_for_trains != VPF_YAPF) return 0;
+					for (const Train *t : Train::Iterate()) {
+						if (!t->IsFrontEngine() || t->IsVirtual() || (t->vehstatus & VS_CRASHED) || IsRailDepotTile(t->tile)) continue;
+						YapfTrainFindNearestDepot(t, 0);
+						searches++;
+					}
+					break;
+
+				case VEH_ROAD:
+					if (_settings_game.pf.pathfinder_for_roadvehs != VPF_YAPF) return 0;
+					for (const RoadVehicle *rv : RoadVehicle::Iterate()) {
+						if (!rv->IsFrontEngine() || (rv->vehstatus & VS_CRASHED) || IsRoadDepotTile(rv->tile)) continue;
+						YapfRoadVehicleFindNearestDepot(rv, 0);
+						searches++;
+					}
+					break;
+
+				case VEH_SHIP:
+					if (_settings_game.pf.pathfinder_for_ships != VPF_YAPF) return 0;
+					for (const Ship *s : Ship::Iterate()) {
+						if (s->IsInDepot() || s->state == TRACK_BIT_WORMHOLE || (s->vehstatus & VS_CRASHED)) continue;
+						YapfShipCheckReverse(s, nullptr);
+						searches++;
+					}
+					break;
+
+				default:
+					NOT_REACHED();
+			}
+		}
+		return searches;
+	};
+
+	for (uint type = VEH_TRAIN; type <= VEH_SHIP; type++) {
+		uint64 ns[2];
+		uint searches = 0;
+		for (uint pooled = 0; pooled < 2; pooled++) {
+			_yapf_node_list_pool_disabled = (pooled == 0);
+			auto start = std::chrono::steady_clock::now();
+			searches = run_searches((VehicleType)type);
+			ns[pooled] = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+		}
+		_yapf_node_list_pool_disabled = false;
+		if (searches == 0) continue;
+		b += seprintf(b, last, "%s: %u searches, allocated per search: %.3f ms (%.1f us/search), reused: %.3f ms (%.1f us/search), %.1f%% faster\n",
+				_yapf_search_type_names[type], searches, ns[0] / 1000000.0, ns[0] / 1000.0 / searches, ns[1] / 1000000.0, ns[1] / 1000.0 / searches,
+				ns[0] > 0 ? 100.0 * ((double)ns[0] - (double)ns[1]) / ns[0] : 0.0);
+	}
+
+	std::vector<YapfHeapBenchmarkItem> items(1000000);
+	uint64 binary_checksum;
+	uint64 quaternary_checksum;
+	const uint64 binary_us = TimeBenchmarkYapfHeap<CBinaryHeapT<YapfHeapBenchmarkItem>>(items, binary_checksum);
+	const uint64 quaternary_us = TimeBenchmarkYapfHeap<CQuaternaryHeapT<YapfHeapBenchmarkItem>>(items, quaternary_checksum);
+	b += seprintf(b, last, "Heap, %u items: binary: " OTTD_PRINTF64U " us, 4-ary: " OTTD_PRINTF64U " us\n", (uint)items.size(), binary_us, quaternary_us);
+	if (binary_checksum != quaternary_checksum) b += seprintf(b, last, "  Results differ!\n");
+	return b;
+}
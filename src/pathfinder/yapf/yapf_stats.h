@@ -0,0 +1,64 @@
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file yapf_stats.h Statistics of the YAPF searches, per vehicle type. */
+
+#ifndef YAPF_STATS_H
+#define YAPF_STATS_H
+
+#include "../../tile_type.h"
+#include "../../vehicle_type.h"
+#include <array>
+
+/** Histogram with power of two sized buckets: bucket 0 counts zero values, bucket i counts values in [2^(i-1), 2^i). */
+struct YapfStatsHistogram {
+	static const uint BUCKETS = 20; ///< the last bucket also counts all larger values
+
+	std::array<uint64, BUCKETS> buckets{};
+
+	void Add(uint64 value);
+};
+
+/** Measurements of a single search, see CYapfBaseT::FindPath. */
+struct YapfSearchRecord {
+	uint64 ns;           ///< duration of the search
+	uint nodes_opened;   ///< number of nodes added to the open list
+	uint nodes_closed;   ///< number of nodes moved to the closed list
+	uint cost_calcs;     ///< number of node costs which were calculated
+	uint cache_hits;     ///< number of node costs which were reused from the segment cost cache
+	bool path_found;     ///< the search reached the destination
+	bool cutoff;         ///< the search was stopped by max_search_nodes
+};
+
+/** Accumulated statistics of the searches for one vehicle type. */
+struct YapfSearchStats {
+	uint64 searches = 0;
+	uint64 paths_found = 0;
+	uint64 cutoffs = 0;
+	uint64 nodes_opened = 0;
+	uint64 nodes_closed = 0;
+	uint64 cost_calcs = 0;
+	uint64 cache_hits = 0;
+	uint64 total_ns = 0;
+
+	YapfStatsHistogram opened_histogram;     ///< nodes opened per search
+	YapfStatsHistogram closed_histogram;     ///< nodes closed per search
+	YapfStatsHistogram latency_histogram;    ///< duration per search, in microseconds
+
+	uint64 slowest_ns = 0;                   ///< duration of the slowest search
+	uint slowest_nodes = 0;                  ///< nodes opened by the slowest search
+	VehicleID slowest_vehicle = INVALID_VEHICLE; ///< vehicle of the slowest search
+	TileIndex slowest_tile = INVALID_TILE;   ///< vehicle location at the time of the slowest search
+};
+
+void RecordYapfSearch(VehicleType type, VehicleID veh, TileIndex tile, const YapfSearchRecord &record);
+void YapfStatsBeginTick(bool paused);
+void ResetYapfSearchStats();
+char *DumpYapfSearchStats(char *b, const char *last);
+char *DumpYapfSearchStatsCsv(char *b, const char *last);
+
+#endif /* YAPF_STATS_H */
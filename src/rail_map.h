@@ -18,6 +18,7 @@
 #include "water_map.h"
 #include "signal_type.h"
 #include "tunnelbridge_map.h"
+#include "rail_state_region.h"
 
 
 /** Different types of Rail-related tiles */
@@ -244,6 +245,7 @@ static inline void SetTrackReservation(TileIndex t, TrackBits b)
 	Track track = RemoveFirstTrack(&b);
 	SB(_m[t].m2, 8, 3, track == INVALID_TRACK ? 0 : track + 1);
 	SB(_m[t].m2, 11, 1, (byte)(b != TRACK_BIT_NONE));
+	NotifyRailStateChange(t);
 }
 
 /**
@@ -301,6 +303,7 @@ static inline void SetDepotReservation(TileIndex t, bool b)
 {
 	dbg_assert_tile(IsRailDepot(t), t);
 	SB(_m[t].m5, 4, 1, (byte)b);
+	NotifyRailStateChange(t);
 }
 
 /**
@@ -450,6 +453,7 @@ static inline void SetSignalAlwaysReserveThrough(TileIndex t, Track track, bool
 static inline void SetSignalStates(TileIndex tile, uint state)
 {
 	SB(_m[tile].m4, 4, 4, state);
+	NotifyRailStateChange(tile);
 }
 
 /**
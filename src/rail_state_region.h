@@ -0,0 +1,49 @@
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file rail_state_region.h Versions of the rail reservation and signal state of map regions, used by the YAPF rail route cache. */
+
+#ifndef RAIL_STATE_REGION_H
+#define RAIL_STATE_REGION_H
+
+#include "map_func.h"
+
+/** Log2 of the side length in tiles of the regions in which rail reservation and signal state changes are tracked. */
+static const uint RAIL_STATE_REGION_SHIFT = 4;
+
+extern uint32 *_rail_state_region_versions;
+
+/**
+ * Get the number of rail state regions of the current map.
+ * @return number of entries of _rail_state_region_versions
+ */
+static inline uint GetRailStateRegionCount()
+{
+	return (MapSizeX() >> RAIL_STATE_REGION_SHIFT) * (MapSizeY() >> RAIL_STATE_REGION_SHIFT);
+}
+
+/**
+ * Get the index of the rail state region containing a tile.
+ * @param tile the tile
+ * @return index into _rail_state_region_versions
+ */
+static inline uint GetRailStateRegionIndex(TileIndex tile)
+{
+	return ((TileY(tile) >> RAIL_STATE_REGION_SHIFT) << (MapLogX() - RAIL_STATE_REGION_SHIFT)) | (TileX(tile) >> RAIL_STATE_REGION_SHIFT);
+}
+
+/**
+ * Notify that the reservation or signal state of a tile has changed.
+ * This invalidates the cached rail routes which depended on the state of the surrounding region.
+ * @param tile the tile that is changed
+ */
+static inline void NotifyRailStateChange(TileIndex tile)
+{
+	_rail_state_region_versions[GetRailStateRegionIndex(tile)]++;
+}
+
+#endif /* RAIL_STATE_REGION_H */
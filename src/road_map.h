@@ -15,6 +15,7 @@
 #include "rail_type.h"
 #include "road_func.h"
 #include "tile_map.h"
+#include "rail_state_region.h"
 
 
 /** The different types of road tiles. */
@@ -446,6 +447,7 @@ static inline void SetCrossingReservation(TileIndex t, bool b)
 {
 	assert_tile(IsLevelCrossingTile(t), t);
 	SB(_m[t].m5, 4, 1, b ? 1 : 0);
+	NotifyRailStateChange(t);
 }
 
 /**
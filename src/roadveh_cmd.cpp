@@ -1278,7 +1278,7 @@ static Trackdir RoadFindPathToDest(RoadVehicle *v, TileIndex tile, DiagDirection
 		default: NOT_REACHED();
 	}
 	DEBUG_UPDATESTATECHECKSUM("RoadFindPathToDest: v: %u, path_found: %d, best_track: %d", v->index, path_found, best_track);
-	UpdateStateChecksum((((uint64) v->index) << 32) | (path_found << 16) | best_track);
+	UpdateStateChecksum((((uint64) v->index) << 32) | (path_found << 16) | best_track, SCS_ROAD_VEHICLES);
 	v->HandlePathfindingResult(path_found);
 
 found_best_track:;
@@ -1294,6 +1294,48 @@ struct RoadDriveEntry {
 
 #include "table/roadveh_movement.h"
 
+/**
+ * Resolve the paths of the road vehicles which are expected to enter a junction in this tick, on the worker pool.
+ * The results are only taken by RoadFindPathToDest when they match, see YapfRoadVehiclePrefetchPaths.
+ * @param vehicles The front engines of the road vehicles, in tick order.
+ */
+void PrefetchRoadVehiclePaths(const std::vector<RoadVehicle *> &vehicles)
+{
+	if (_settings_game.pf.pathfinder_for_roadvehs != VPF_YAPF) return;
+
+	std::vector<YapfPathRequest> requests;
+	for (RoadVehicle *v : vehicles) {
+		if (v->vehstatus & (VS_STOPPED | VS_CRASHED)) continue;
+		if (v->IsInDepot() || v->state == RVSB_WORMHOLE || v->dest_tile == 0 || !v->path.empty()) continue;
+		if (v->reverse_ctr != 0 || v->blocked_ctr != 0 || v->cur_speed == 0) continue;
+		if (v->current_order.IsType(OT_LOADING) || v->current_order.IsType(OT_WAITING)) continue;
+
+		/* Upper bound of the number of steps the vehicle advances in this tick. */
+		const uint max_steps = (v->GetAdvanceSpeed(std::max<uint>(v->cur_speed, v->vcache.cached_max_speed)) + v->progress) / 192;
+
+		const RoadDriveEntry *rdp = _road_drive_data[GetRoadTramType(v->roadtype)][(
+			(HasBit(v->state, RVS_IN_DT_ROAD_STOP) ? v->state & RVSB_ROAD_STOP_TRACKDIR_MASK : v->state) +
+			(_settings_game.vehicle.road_side << RVS_DRIVE_SIDE)) ^ v->overtaking];
+		for (uint i = 1; i <= max_steps; i++) {
+			const RoadDriveEntry rd = rdp[v->frame + i];
+			if (rd.x & RDE_TURNED) break;
+			if (rd.x & RDE_NEXT_TILE) {
+				const DiagDirection enterdir = (DiagDirection)(rd.x & 3);
+				const TileIndex tile = v->tile + TileOffsByDiagDir(enterdir);
+				if (!HasTileAnyRoadType(tile, v->compatible_roadtypes)) break;
+
+				/* Only junctions need a search. */
+				TrackdirBits trackdirs = TrackStatusToTrackdirBits(GetTileTrackStatus(tile, TRANSPORT_ROAD, ((v->roadtype + 1) << 8) | GetRoadTramType(v->roadtype)));
+				trackdirs &= DiagdirReachesTrackdirs(enterdir);
+				if (KillFirstBit(trackdirs) != TRACKDIR_BIT_NONE) requests.push_back({ v, tile, enterdir, TRACK_BIT_NONE });
+				break;
+			}
+		}
+	}
+
+	if (!requests.empty()) YapfRoadVehiclePrefetchPaths(requests);
+}
+
 static bool RoadVehLeaveDepot(RoadVehicle *v, bool first)
 {
 	/* Don't leave unless v and following wagons are in the depot. */
@@ -2211,9 +2253,9 @@ Money RoadVehicle::GetRunningCost() const
 bool RoadVehicle::Tick()
 {
 	DEBUG_UPDATESTATECHECKSUM("RoadVehicle::Tick 1: v: %u, x: %d, y: %d", this->index, this->x_pos, this->y_pos);
-	UpdateStateChecksum((((uint64) this->x_pos) << 32) | this->y_pos);
+	UpdateStateChecksum((((uint64) this->x_pos) << 32) | this->y_pos, SCS_ROAD_VEHICLES);
 	DEBUG_UPDATESTATECHECKSUM("RoadVehicle::Tick 2: v: %u, state: %d, frame: %d", this->index, this->state, this->frame);
-	UpdateStateChecksum((((uint64) this->state) << 32) | this->frame);
+	UpdateStateChecksum((((uint64) this->state) << 32) | this->frame, SCS_ROAD_VEHICLES);
 	if (this->IsFrontEngine()) {
 		if (!(this->IsRoadVehicleStopped() || this->IsWaitingInDepot())) this->running_ticks++;
 		return RoadVehController(this);
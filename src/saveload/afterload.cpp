@@ -79,6 +79,7 @@
 
 #include <signal.h>
 #include <algorithm>
+#include <chrono>
 
 #include "../safeguards.h"
 
@@ -329,6 +330,21 @@ static void InitializeWindowsAndCaches()
 	BuildOwnerLegend();
 }
 
+/**
+ * Run a stage of the after load processing, and log its duration at sl debug level 2.
+ * This makes the cost of the individual stages on large savegames visible.
+ * @param name Name of the stage, for the timing log.
+ * @param proc Function which runs the stage.
+ */
+template <typename F>
+static void RunTimedAfterLoadStage(const char *name, F proc)
+{
+	const auto start = std::chrono::steady_clock::now();
+	proc();
+	const uint64 duration = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+	DEBUG(sl, 2, "After load stage %s: " OTTD_PRINTF64U " us", name, duration);
+}
+
 #ifdef WITH_SIGACTION
 static struct sigaction _prev_segfault;
 static struct sigaction _prev_abort;
@@ -662,6 +678,8 @@ static void StartScripts()
  */
 bool AfterLoadGame()
 {
+	const auto after_load_start = std::chrono::steady_clock::now();
+
 	SetSignalHandlers();
 
 	TileIndex map_size = MapSize();
@@ -734,25 +752,25 @@ bool AfterLoadGame()
 
 		/* In old savegame versions, the heightlevel was coded in bits 0..3 of the type field */
 		for (TileIndex t = 0; t < map_size; t++) {
-			_m[t].height = GB(_m[t].type, 0, 4);
-			SB(_m[t].type, 0, 2, GB(_me[t].m6, 0, 2));
+			TileHeightByte(t) = GB(TileTypeByte(t), 0, 4);
+			SB(TileTypeByte(t), 0, 2, GB(_me[t].m6, 0, 2));
 			SB(_me[t].m6, 0, 2, 0);
 			if (MayHaveBridgeAbove(t)) {
-				SB(_m[t].type, 2, 2, GB(_me[t].m6, 6, 2));
+				SB(TileTypeByte(t), 2, 2, GB(_me[t].m6, 6, 2));
 				SB(_me[t].m6, 6, 2, 0);
 			} else {
-				SB(_m[t].type, 2, 2, 0);
+				SB(TileTypeByte(t), 2, 2, 0);
 			}
 		}
 	} else if (IsSavegameVersionBefore(SLV_194) && SlXvIsFeaturePresent(XSLFI_HEIGHT_8_BIT)) {
 		for (TileIndex t = 0; t < map_size; t++) {
-			SB(_m[t].type, 0, 2, GB(_me[t].m6, 0, 2));
+			SB(TileTypeByte(t), 0, 2, GB(_me[t].m6, 0, 2));
 			SB(_me[t].m6, 0, 2, 0);
 			if (MayHaveBridgeAbove(t)) {
-				SB(_m[t].type, 2, 2, GB(_me[t].m6, 6, 2));
+				SB(TileTypeByte(t), 2, 2, GB(_me[t].m6, 6, 2));
 				SB(_me[t].m6, 6, 2, 0);
 			} else {
-				SB(_m[t].type, 2, 2, 0);
+				SB(TileTypeByte(t), 2, 2, 0);
 			}
 		}
 	}
@@ -919,8 +937,10 @@ bool AfterLoadGame()
 	}
 
 	/* Load the sprites */
-	GfxLoadSprites();
-	LoadStringWidthTable();
+	RunTimedAfterLoadStage("sprites", []() {
+		GfxLoadSprites();
+		LoadStringWidthTable();
+	});
 	ReInitAllWindows(false);
 
 	/* Copy temporary data to Engine pool */
@@ -1018,7 +1038,7 @@ bool AfterLoadGame()
 	AnalyseHouseSpriteGroups();
 
 	/* Update all vehicles */
-	AfterLoadVehicles(true);
+	RunTimedAfterLoadStage("vehicles", []() { AfterLoadVehicles(true); });
 
 	CargoPacket::PostVehiclesAfterLoad();
 
@@ -1779,7 +1799,7 @@ bool AfterLoadGame()
 		c->avail_roadtypes = GetCompanyRoadTypes(c->index);
 	}
 
-	AfterLoadStations();
+	RunTimedAfterLoadStage("stations", AfterLoadStations);
 
 	/* Time starts at 0 instead of 1920.
 	 * Account for this in older games by adding an offset */
@@ -1876,7 +1896,7 @@ bool AfterLoadGame()
 	}
 
 	/* Check and update house and town values */
-	UpdateHousesAndTowns(gcf_res != GLC_ALL_GOOD, true);
+	RunTimedAfterLoadStage("houses and towns", [&]() { UpdateHousesAndTowns(gcf_res != GLC_ALL_GOOD, true); });
 
 	if (IsSavegameVersionBefore(SLV_43)) {
 		for (TileIndex t = 0; t < map_size; t++) {
@@ -3896,7 +3916,7 @@ bool AfterLoadGame()
 	}
 
 	/* Compute station catchment areas. This is needed here in case UpdateStationAcceptance is called below. */
-	Station::RecomputeCatchmentForAll();
+	RunTimedAfterLoadStage("station catchment", []() { Station::RecomputeCatchmentForAll(); });
 
 	/* Station acceptance is some kind of cache */
 	if (IsSavegameVersionBefore(SLV_127)) {
@@ -4225,14 +4245,14 @@ bool AfterLoadGame()
 	InitializeRoadGUI();
 
 	/* This needs to be done after conversion. */
-	RebuildViewportKdtree();
-	ViewportMapBuildTunnelCache();
+	RunTimedAfterLoadStage("viewport kdtree", RebuildViewportKdtree);
+	RunTimedAfterLoadStage("tunnel cache", ViewportMapBuildTunnelCache);
 
 	/* Road stops is 'only' updating some caches */
-	AfterLoadRoadStops();
-	AfterLoadLabelMaps();
-	AfterLoadCompanyStats();
-	AfterLoadStoryBook();
+	RunTimedAfterLoadStage("road stops", AfterLoadRoadStops);
+	RunTimedAfterLoadStage("label maps", AfterLoadLabelMaps);
+	RunTimedAfterLoadStage("company stats", AfterLoadCompanyStats);
+	RunTimedAfterLoadStage("story book", AfterLoadStoryBook);
 
 	AfterLoadVehiclesRemoveAnyFoundInvalid();
 
@@ -4240,13 +4260,13 @@ bool AfterLoadGame()
 
 	SetupTickRate();
 
-	InitializeWindowsAndCaches();
+	RunTimedAfterLoadStage("windows and caches", InitializeWindowsAndCaches);
 	/* Restore the signals */
 	ResetSignalHandlers();
 
-	AfterLoadLinkGraphs();
+	RunTimedAfterLoadStage("link graphs", AfterLoadLinkGraphs);
 
-	AfterLoadTraceRestrict();
+	RunTimedAfterLoadStage("trace restrict", AfterLoadTraceRestrict);
 	AfterLoadTemplateVehiclesUpdate();
 	if (SlXvIsFeaturePresent(XSLFI_TEMPLATE_REPLACEMENT, 1, 7)) {
 		AfterLoadTemplateVehiclesUpdateProperties();
@@ -4308,6 +4328,8 @@ bool AfterLoadGame()
 		c->settings = _settings_client.company;
 	}
 
+	DEBUG(sl, 2, "After load: " OTTD_PRINTF64U " us", (uint64)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - after_load_start).count());
+
 	return true;
 }
 
@@ -173,6 +173,9 @@ struct GUISettings : public TimeSettings {
 	uint16 autosave_custom_days;             ///< custom autosave interval in days
 	uint16 autosave_custom_minutes;          ///< custom autosave interval in real-time minutes
 	bool   threaded_saves;                   ///< should we do threaded saves?
+	uint16 threaded_save_buffer_limit;       ///< maximum amount of serialised savegame data (in MiB) waiting to be written by a threaded save, 0 = unlimited
+	bool   yapf_rail_route_cache;            ///< should the results of non-reserving rail pathfinder searches be cached?
+	bool   parallel_vehicle_pathfinding;     ///< should road vehicle and ship paths be searched ahead of their tick loops on the worker pool?
 	bool   keep_all_autosave;                ///< name the autosave in a different way
 	bool   autosave_on_exit;                 ///< save an autosave when you quit the game, but do not ask "Do you really want to quit?"
 	bool   autosave_on_network_disconnect;   ///< save an autosave when you get disconnected from a network game with an error?
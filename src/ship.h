@@ -19,6 +19,7 @@ extern const DiagDirection _ship_search_directions[TRACK_END][DIAGDIR_END];
 
 void GetShipSpriteSize(EngineID engine, uint &width, uint &height, int &xoffs, int &yoffs, EngineImageType image_type);
 WaterClass GetEffectiveWaterClass(TileIndex tile);
+void PrefetchShipPaths(const std::vector<Ship *> &ships);
 
 typedef std::deque<Trackdir> ShipPathCache;
 
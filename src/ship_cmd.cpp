@@ -587,7 +587,7 @@ static Track ChooseShipTrack(Ship *v, TileIndex tile, DiagDirection enterdir, Tr
 		}
 	}
 	DEBUG_UPDATESTATECHECKSUM("ChooseShipTrack: v: %u, path_found: %d, track: %d", v->index, path_found, track);
-	UpdateStateChecksum((((uint64) v->index) << 32) | (path_found << 16) | track);
+	UpdateStateChecksum((((uint64) v->index) << 32) | (path_found << 16) | track, SCS_SHIPS);
 
 	v->HandlePathfindingResult(path_found);
 	return track;
@@ -606,6 +606,45 @@ static inline TrackBits GetAvailShipTracks(TileIndex tile, DiagDirection dir)
 	return tracks;
 }
 
+/**
+ * Resolve the paths of the ships which are expected to enter a new tile in this tick, on the worker pool.
+ * The results are only taken by ChooseShipTrack when they match, see YapfShipPrefetchPaths.
+ * @param ships The ships, in tick order.
+ */
+void PrefetchShipPaths(const std::vector<Ship *> &ships)
+{
+	if (_settings_game.pf.pathfinder_for_ships != VPF_YAPF) return;
+
+	std::vector<YapfPathRequest> requests;
+	for (Ship *v : ships) {
+		if (v->vehstatus & (VS_STOPPED | VS_CRASHED)) continue;
+		if (v->IsInDepot() || v->state == TRACK_BIT_WORMHOLE || v->dest_tile == 0 || !v->path.empty()) continue;
+		if (v->current_order.IsType(OT_LOADING) || v->direction != v->rotation || !IsDiagonalDirection(v->direction)) continue;
+
+		/* Number of steps to the edge of the tile, and an upper bound of the number of steps in this tick. */
+		const DiagDirection exitdir = DirToDiagDir(v->direction);
+		uint steps;
+		switch (exitdir) {
+			case DIAGDIR_NE: steps = (v->x_pos & 0xF) + 1; break;
+			case DIAGDIR_SW: steps = 16 - (v->x_pos & 0xF); break;
+			case DIAGDIR_NW: steps = (v->y_pos & 0xF) + 1; break;
+			case DIAGDIR_SE: steps = 16 - (v->y_pos & 0xF); break;
+			default: NOT_REACHED();
+		}
+		const uint max_steps = (v->GetAdvanceSpeed(v->cur_speed + 1) + v->progress) / v->GetAdvanceDistance();
+		if (steps > max_steps) continue;
+
+		const TileIndex tile = TileAddByDiagDir(v->tile, exitdir);
+		if (!IsValidTile(tile)) continue;
+		const TrackBits tracks = GetAvailShipTracks(tile, exitdir);
+		if (tracks == TRACK_BIT_NONE || tile == v->dest_tile) continue;
+
+		requests.push_back({ v, tile, exitdir, tracks });
+	}
+
+	if (!requests.empty()) YapfShipPrefetchPaths(requests);
+}
+
 /** Structure for ship sub-coordinate data for moving into a new tile via a Diagdir onto a Track. */
 struct ShipSubcoordData {
 	byte x_subcoord; ///< New X sub-coordinate on the new tile
@@ -1096,7 +1135,7 @@ static void ShipController(Ship *v)
 bool Ship::Tick()
 {
 	DEBUG_UPDATESTATECHECKSUM("Ship::Tick: v: %u, x: %d, y: %d", this->index, this->x_pos, this->y_pos);
-	UpdateStateChecksum((((uint64) this->x_pos) << 32) | this->y_pos);
+	UpdateStateChecksum((((uint64) this->x_pos) << 32) | this->y_pos, SCS_SHIPS);
 	if (!((this->vehstatus & VS_STOPPED) || this->IsWaitingInDepot())) this->running_ticks++;
 
 	ShipController(this);
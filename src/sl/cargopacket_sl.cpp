@@ -132,6 +132,9 @@ SaveLoadTable GetCargoPacketDesc()
  */
 static void Save_CAPA()
 {
+	/* Packets in vehicles may have deferred aging, see VehicleCargoList::AgeCargo. */
+	for (Vehicle *v : Vehicle::Iterate()) v->cargo.MaterialiseAge();
+
 	std::vector<SaveLoad> filtered_packet_desc = SlFilterObject(GetCargoPacketDesc());
 	for (CargoPacket *cp : CargoPacket::Iterate()) {
 		SlSetArrayIndex(cp->index);
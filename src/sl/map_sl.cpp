@@ -63,7 +63,7 @@ static void Load_MAPT()
 
 	for (TileIndex i = 0; i != size;) {
 		SlArray(buf.data(), MAP_SL_BUF_SIZE, SLE_UINT8);
-		for (uint j = 0; j != MAP_SL_BUF_SIZE; j++) _m[i++].type = buf[j];
+		for (uint j = 0; j != MAP_SL_BUF_SIZE; j++) TileTypeByte(i++) = buf[j];
 	}
 }
 
@@ -93,7 +93,7 @@ static void Load_MAPH()
 
 			for (TileIndex i = 0; i != size;) {
 				SlArray(buf.data(), MAP_SL_BUF_SIZE, SLE_UINT16);
-				for (uint j = 0; j != MAP_SL_BUF_SIZE; j++) _m[i++].height = buf[j];
+				for (uint j = 0; j != MAP_SL_BUF_SIZE; j++) TileHeightByte(i++) = buf[j];
 			}
 		}
 		return;
@@ -104,7 +104,7 @@ static void Load_MAPH()
 
 	for (TileIndex i = 0; i != size;) {
 		SlArray(buf.data(), MAP_SL_BUF_SIZE, SLE_UINT8);
-		for (uint j = 0; j != MAP_SL_BUF_SIZE; j++) _m[i++].height = buf[j];
+		for (uint j = 0; j != MAP_SL_BUF_SIZE; j++) TileHeightByte(i++) = buf[j];
 	}
 }
 
@@ -212,16 +212,85 @@ static void Load_MAP8()
 	}
 }
 
+#ifdef WITH_SPLIT_MAP_ARRAYS
+/** Number of bytes of a tile in the first part of the WMAP chunk: type, height, m2 (little endian), m1, m3, m4 and m5. */
+static const size_t WMAP_TILE_BYTES = 8;
+
+#if TTD_ENDIAN == TTD_LITTLE_ENDIAN
+/* The WMAP tile bytes after the type and height have the layout of Tile, so they can be copied as a whole */
+static_assert(sizeof(Tile) == WMAP_TILE_BYTES - 2);
+static_assert(offsetof(Tile, m2) == 0 && offsetof(Tile, m1) == 2 && offsetof(Tile, m3) == 3 && offsetof(Tile, m4) == 4 && offsetof(Tile, m5) == 5);
+#endif
+
+/**
+ * Decode the tiles of the first part of a WMAP chunk into the split map arrays.
+ * @param p The WMAP data of the first tile.
+ * @param begin The first tile.
+ * @param end The tile after the last tile.
+ */
+static void DecodeWMAPTiles(const byte *p, TileIndex begin, TileIndex end)
+{
+	for (TileIndex i = begin; i != end; i++, p += WMAP_TILE_BYTES) {
+		_m_type[i] = p[0];
+		_m_height[i] = p[1];
+#if TTD_ENDIAN == TTD_LITTLE_ENDIAN
+		memcpy(&_m[i], p + 2, sizeof(Tile));
+#else
+		_m[i].m2 = p[2] | (p[3] << 8);
+		_m[i].m1 = p[4];
+		_m[i].m3 = p[5];
+		_m[i].m4 = p[6];
+		_m[i].m5 = p[7];
+#endif
+	}
+}
+
+/**
+ * Encode tiles of the split map arrays into the first part of a WMAP chunk.
+ * @param p The WMAP data of the first tile.
+ * @param begin The first tile.
+ * @param end The tile after the last tile.
+ */
+static void EncodeWMAPTiles(byte *p, TileIndex begin, TileIndex end)
+{
+	for (TileIndex i = begin; i != end; i++, p += WMAP_TILE_BYTES) {
+		p[0] = _m_type[i];
+		p[1] = _m_height[i];
+#if TTD_ENDIAN == TTD_LITTLE_ENDIAN
+		memcpy(p + 2, &_m[i], sizeof(Tile));
+#else
+		p[2] = GB(_m[i].m2, 0, 8);
+		p[3] = GB(_m[i].m2, 8, 8);
+		p[4] = _m[i].m1;
+		p[5] = _m[i].m3;
+		p[6] = _m[i].m4;
+		p[7] = _m[i].m5;
+#endif
+	}
+}
+#endif /* WITH_SPLIT_MAP_ARRAYS */
+
 static void Load_WMAP()
 {
+#ifndef WITH_SPLIT_MAP_ARRAYS
 	static_assert(sizeof(Tile) == 8);
+#endif
 	static_assert(sizeof(TileExtended) == 4);
 	assert(_sl_xv_feature_versions[XSLFI_WHOLE_MAP_CHUNK] == 1 || _sl_xv_feature_versions[XSLFI_WHOLE_MAP_CHUNK] == 2);
 
 	ReadBuffer *reader = ReadBuffer::GetCurrent();
 	const TileIndex size = MapSize();
 
-#if TTD_ENDIAN == TTD_LITTLE_ENDIAN
+#if defined(WITH_SPLIT_MAP_ARRAYS)
+	/* The type and height are not stored in Tile, so the tiles are decoded from the buffer in place */
+	for (TileIndex i = 0; i != size;) {
+		reader->CheckBytes(WMAP_TILE_BYTES);
+		const TileIndex count = std::min<TileIndex>(size - i, (reader->bufe - reader->bufp) / WMAP_TILE_BYTES);
+		DecodeWMAPTiles(reader->bufp, i, i + count);
+		reader->bufp += count * WMAP_TILE_BYTES;
+		i += count;
+	}
+#elif TTD_ENDIAN == TTD_LITTLE_ENDIAN
 	reader->CopyBytes((byte *) _m, size * 8);
 #else
 	for (TileIndex i = 0; i != size; i++) {
@@ -264,7 +333,9 @@ static void Load_WMAP()
 
 static void Save_WMAP()
 {
+#ifndef WITH_SPLIT_MAP_ARRAYS
 	static_assert(sizeof(Tile) == 8);
+#endif
 	static_assert(sizeof(TileExtended) == 4);
 	assert(_sl_xv_feature_versions[XSLFI_WHOLE_MAP_CHUNK] == 2);
 
@@ -272,9 +343,17 @@ static void Save_WMAP()
 	const TileIndex size = MapSize();
 	SlSetLength(size * 12);
 
-#if TTD_ENDIAN == TTD_LITTLE_ENDIAN
+#if defined(WITH_SPLIT_MAP_ARRAYS)
+	/* The tiles are encoded into the dump buffer in place */
+	for (TileIndex i = 0; i != size;) {
+		dumper->CheckBytes(WMAP_TILE_BYTES);
+		const TileIndex count = std::min<TileIndex>(size - i, (dumper->bufe - dumper->buf) / WMAP_TILE_BYTES);
+		EncodeWMAPTiles(dumper->buf, i, i + count);
+		dumper->buf += count * WMAP_TILE_BYTES;
+		i += count;
+	}
+#elif TTD_ENDIAN == TTD_LITTLE_ENDIAN
 	dumper->CopyBytes((byte *) _m, size * 8);
-	dumper->CopyBytes((byte *) _me, size * 4);
 #else
 	for (TileIndex i = 0; i != size; i++) {
 		dumper->CheckBytes(8);
@@ -287,6 +366,11 @@ static void Save_WMAP()
 		dumper->RawWriteByte(_m[i].m4);
 		dumper->RawWriteByte(_m[i].m5);
 	}
+#endif
+
+#if TTD_ENDIAN == TTD_LITTLE_ENDIAN
+	dumper->CopyBytes((byte *) _me, size * 4);
+#else
 	for (TileIndex i = 0; i != size; i++) {
 		dumper->CheckBytes(4);
 		dumper->RawWriteByte(_me[i].m6);
@@ -299,12 +383,12 @@ static void Save_WMAP()
 
 struct MAPT {
 	typedef uint8 FieldT;
-	static const FieldT &GetField(TileIndex t) { return _m[t].type; }
+	static const FieldT &GetField(TileIndex t) { return TileTypeByte(t); }
 };
 
 struct MAPH {
 	typedef uint8 FieldT;
-	static const FieldT &GetField(TileIndex t) { return _m[t].height; }
+	static const FieldT &GetField(TileIndex t) { return TileHeightByte(t); }
 };
 
 struct MAP1 {
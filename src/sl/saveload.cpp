@@ -45,7 +45,9 @@
 #include "../load_check.h"
 #include "../error.h"
 #include "../scope.h"
+#include "../worker_thread.h"
 #include <atomic>
+#include <chrono>
 #include <deque>
 #include <string>
 #ifdef __EMSCRIPTEN__
@@ -150,6 +152,108 @@ void ReadBuffer::AcquireBytes()
 	this->bufe = this->buf + remainder + len;
 }
 
+/**
+ * Queue of completed savegame blocks, passed from the main thread saving the chunks to the savegame thread
+ * which compresses and writes them, such that the whole savegame does not need to be held in memory.
+ */
+struct SaveBlockQueue {
+	std::mutex lock;
+	std::condition_variable cv;
+	std::deque<MemoryDumper::BufferInfo> blocks; ///< Completed blocks which have not yet been written.
+	size_t queued_bytes = 0;                     ///< Total size of the queued blocks.
+	const size_t limit;                          ///< Maximum queued size before the main thread waits for the savegame thread, 0 = unlimited.
+	bool finished = false;                       ///< All blocks have been queued.
+	bool aborted = false;                        ///< Saving the chunks failed, no further blocks will be queued.
+	bool writer_failed = false;                  ///< Writing the savegame failed, further blocks are discarded.
+
+	/* Statistics, only accessed by the main thread. */
+	size_t peak_queued_bytes = 0;                ///< Maximum value of queued_bytes.
+	std::chrono::steady_clock::duration wait_time{}; ///< Time the main thread spent waiting for the savegame thread.
+
+	SaveBlockQueue(size_t limit) : limit(limit) {}
+
+	/**
+	 * Queue a completed block, waiting for the savegame thread first if too much data is queued.
+	 * @param block Block to queue.
+	 */
+	void Push(MemoryDumper::BufferInfo &&block)
+	{
+		std::unique_lock<std::mutex> lk(this->lock);
+		if (this->writer_failed) return;
+		if (this->limit != 0 && this->queued_bytes >= this->limit) {
+			const auto start = std::chrono::steady_clock::now();
+			this->cv.wait(lk, [this]() { return this->queued_bytes < this->limit || this->writer_failed; });
+			this->wait_time += std::chrono::steady_clock::now() - start;
+			if (this->writer_failed) return;
+		}
+		this->queued_bytes += block.size;
+		this->peak_queued_bytes = std::max(this->peak_queued_bytes, this->queued_bytes);
+		this->blocks.push_back(std::move(block));
+		lk.unlock();
+		this->cv.notify_all();
+	}
+
+	/**
+	 * Mark the queue as finished or aborted by the main thread.
+	 * @param abort True if saving the chunks failed.
+	 */
+	void Finish(bool abort)
+	{
+		std::unique_lock<std::mutex> lk(this->lock);
+		if (abort) {
+			this->aborted = true;
+		} else {
+			this->finished = true;
+		}
+		lk.unlock();
+		this->cv.notify_all();
+	}
+
+	/**
+	 * Write all blocks to the writer as they are queued, until the queue is finished or aborted.
+	 * This is called by the savegame thread.
+	 * @param writer The filter to write to.
+	 * @return False if the queue was aborted.
+	 */
+	bool WriteTo(SaveFilter *writer)
+	{
+		std::unique_lock<std::mutex> lk(this->lock);
+		while (true) {
+			this->cv.wait(lk, [this]() { return !this->blocks.empty() || this->finished || this->aborted; });
+			if (this->aborted) return false;
+			if (this->blocks.empty()) return true;
+
+			MemoryDumper::BufferInfo block = std::move(this->blocks.front());
+			this->blocks.pop_front();
+			lk.unlock();
+			writer->Write(block.data, block.size);
+			lk.lock();
+			this->queued_bytes -= block.size;
+			this->cv.notify_all();
+		}
+	}
+
+	/**
+	 * Mark that writing the savegame failed, and wait for the main thread to stop queueing blocks.
+	 * This is called by the savegame thread.
+	 */
+	void WriterFailed()
+	{
+		std::unique_lock<std::mutex> lk(this->lock);
+		this->writer_failed = true;
+		this->blocks.clear();
+		this->queued_bytes = 0;
+		this->cv.notify_all();
+		this->cv.wait(lk, [this]() { return this->finished || this->aborted; });
+	}
+};
+
+MemoryDumper::~MemoryDumper()
+{
+	free(this->autolen_buf);
+	delete this->queue;
+}
+
 void MemoryDumper::FinaliseBlock()
 {
 	assert(this->saved_buf == nullptr);
@@ -157,6 +261,10 @@ void MemoryDumper::FinaliseBlock()
 		size_t s = MEMORY_CHUNK_SIZE - (this->bufe - this->buf);
 		this->blocks.back().size = s;
 		this->completed_block_bytes += s;
+		if (this->queue != nullptr) {
+			this->queue->Push(std::move(this->blocks.back()));
+			this->blocks.pop_back();
+		}
 	}
 	this->buf = this->bufe = nullptr;
 }
@@ -180,10 +288,19 @@ void MemoryDumper::AllocateBuffer()
 
 /**
  * Flush this dumper into a writer.
+ * If blocks are passed to a queue, this writes the queued blocks as they arrive, and must be called from
+ * a different thread than the one saving the chunks.
  * @param writer The filter we want to use.
+ * @return False if the chunks were not completely saved.
  */
-void MemoryDumper::Flush(SaveFilter *writer)
+bool MemoryDumper::Flush(SaveFilter *writer)
 {
+	if (this->queue != nullptr) {
+		if (!this->queue->WriteTo(writer)) return false;
+		writer->Finish();
+		return true;
+	}
+
 	this->FinaliseBlock();
 
 	size_t block_count = this->blocks.size();
@@ -192,6 +309,17 @@ void MemoryDumper::Flush(SaveFilter *writer)
 	}
 
 	writer->Finish();
+	return true;
+}
+
+/**
+ * Pass the last block to the queue and mark it as finished.
+ * The dumper must not be accessed by the calling thread afterwards, as it may be deleted by the savegame thread.
+ */
+void MemoryDumper::FinishQueue()
+{
+	this->FinaliseBlock();
+	this->queue->Finish(false);
 }
 
 void MemoryDumper::StartAutoLength()
@@ -2883,6 +3011,27 @@ struct LZMASaveFilter : SaveFilter {
 	}
 };
 
+/** Compressor for block-parallel LZMA savegames, each block is an independent xz stream. */
+struct LZMABlockCodec {
+	static bool Compress(const byte *in, size_t in_size, std::vector<byte> &out, byte level)
+	{
+		out.resize(lzma_stream_buffer_bound(in_size));
+		size_t out_pos = 0;
+		if (lzma_easy_buffer_encode(level, LZMA_CHECK_CRC32, nullptr, in, in_size, out.data(), &out_pos, out.size()) != LZMA_OK) return false;
+		out.resize(out_pos);
+		return true;
+	}
+
+	static bool Decompress(const byte *in, size_t in_size, byte *out, size_t out_size)
+	{
+		uint64 memlimit = 1 << 28;
+		size_t in_pos = 0;
+		size_t out_pos = 0;
+		if (lzma_stream_buffer_decode(&memlimit, 0, nullptr, in, &in_pos, in_size, out, &out_pos, out_size) != LZMA_OK) return false;
+		return in_pos == in_size && out_pos == out_size;
+	}
+};
+
 #endif /* WITH_LIBLZMA */
 
 /********************************************
@@ -2997,8 +3146,216 @@ struct ZSTDSaveFilter : SaveFilter {
 	}
 };
 
+/** Compressor for block-parallel ZSTD savegames, each block is an independent zstd frame. */
+struct ZSTDBlockCodec {
+	static bool Compress(const byte *in, size_t in_size, std::vector<byte> &out, byte level)
+	{
+		out.resize(ZSTD_compressBound(in_size));
+		size_t ret = ZSTD_compress(out.data(), out.size(), in, in_size, (int)level - 100);
+		if (ZSTD_isError(ret)) return false;
+		out.resize(ret);
+		return true;
+	}
+
+	static bool Decompress(const byte *in, size_t in_size, byte *out, size_t out_size)
+	{
+		size_t ret = ZSTD_decompress(out, out_size, in, in_size);
+		return !ZSTD_isError(ret) && ret == out_size;
+	}
+};
+
 #endif /* WITH_LIBZSTD */
 
+/*********************************************
+ ******** START OF BLOCK-PARALLEL CODE *******
+ *********************************************/
+
+/*
+ * Block-framed variants of the compressed formats.
+ * The uncompressed savegame is split into blocks of at most SAVE_BLOCK_SIZE bytes, each of which is compressed
+ * independently so that the blocks can be compressed and decompressed in parallel on the worker thread pool.
+ * Each block is stored as: compressed size (uint32 BE), uncompressed size (uint32 BE), compressed data.
+ * The stream is terminated by a block header with both sizes set to 0.
+ */
+
+static const size_t SAVE_BLOCK_SIZE = 2 << 20;          ///< Uncompressed size of the blocks written by the block-parallel save filters.
+static const size_t SAVE_BLOCK_MAX_SIZE = 16 << 20;     ///< Maximum accepted uncompressed size of a block when loading.
+
+/**
+ * Get the maximum number of blocks which are compressed or decompressed at the same time.
+ * @return Number of blocks.
+ */
+static size_t GetSaveBlockWindow()
+{
+	return std::max<size_t>(2, 2 * _general_worker_pool.WorkerCount());
+}
+
+/** A single block of a block-parallel save or load filter. */
+struct SaveLoadBlock {
+	std::vector<byte> input;                ///< Data to compress or decompress.
+	std::vector<byte> output;               ///< Compressed or decompressed data.
+	size_t read_offset = 0;                 ///< Offset into output of the data not yet passed on by the load filter.
+	bool failed = false;                    ///< Whether compression or decompression failed.
+	WorkerThreadPool::TaskGroup task;       ///< Compression or decompression task of this block.
+
+	SaveLoadBlock() : task(_general_worker_pool) {}
+};
+
+/**
+ * Filter compressing independent blocks in parallel.
+ * @tparam Tcodec Compressor, with static members Compress(const byte *in, size_t in_size, std::vector<byte> &out, byte level) and Decompress(const byte *in, size_t in_size, byte *out, size_t out_size).
+ */
+template <typename Tcodec>
+struct BlockSaveFilter : SaveFilter {
+	std::deque<std::unique_ptr<SaveLoadBlock>> blocks; ///< Blocks in file order, the last one may still be being filled.
+	const byte compression_level;                      ///< Compression level passed to the compressor.
+	const size_t window;                               ///< Maximum number of blocks in flight.
+
+	/**
+	 * Initialise this filter.
+	 * @param chain             The next filter in this chain.
+	 * @param compression_level The requested level of compression.
+	 */
+	BlockSaveFilter(SaveFilter *chain, byte compression_level) : SaveFilter(chain), compression_level(compression_level), window(GetSaveBlockWindow())
+	{
+	}
+
+	/**
+	 * Write a compressed block to the chain.
+	 * @param block Block to write, its task must have completed.
+	 */
+	void WriteBlock(SaveLoadBlock &block)
+	{
+		if (block.failed) SlError(STR_GAME_SAVELOAD_ERROR_BROKEN_INTERNAL_ERROR, "block compression failed");
+
+		uint32 header[2] = { TO_BE32((uint32)block.output.size()), TO_BE32((uint32)block.input.size()) };
+		this->chain->Write((byte *)header, sizeof(header));
+		this->chain->Write(block.output.data(), block.output.size());
+	}
+
+	/**
+	 * Write all leading blocks which have been compressed.
+	 * @param wait_count Number of leading blocks to wait for, if they are still being compressed.
+	 */
+	void WriteCompletedBlocks(size_t wait_count)
+	{
+		while (!this->blocks.empty()) {
+			SaveLoadBlock &block = *this->blocks.front();
+			if (!block.task.IsDone()) {
+				if (wait_count == 0) break;
+				block.task.Wait();
+			}
+			if (wait_count > 0) wait_count--;
+			this->WriteBlock(block);
+			this->blocks.pop_front();
+		}
+	}
+
+	/** Start compressing the last block, and create a new one to fill. */
+	void SubmitLastBlock()
+	{
+		SaveLoadBlock *block = this->blocks.back().get();
+		const byte level = this->compression_level;
+		block->task.Run([block, level]() {
+			block->failed = !Tcodec::Compress(block->input.data(), block->input.size(), block->output, level);
+		});
+
+		/* Write out whatever has been compressed, and limit the number of blocks waiting to be compressed. */
+		this->WriteCompletedBlocks(this->blocks.size() >= this->window ? this->blocks.size() + 1 - this->window : 0);
+	}
+
+	void Write(byte *buf, size_t size) override
+	{
+		while (size > 0) {
+			if (this->blocks.empty() || this->blocks.back()->input.size() == SAVE_BLOCK_SIZE) {
+				this->blocks.push_back(std::make_unique<SaveLoadBlock>());
+				this->blocks.back()->input.reserve(SAVE_BLOCK_SIZE);
+			}
+			std::vector<byte> &input = this->blocks.back()->input;
+			const size_t len = std::min(size, SAVE_BLOCK_SIZE - input.size());
+			input.insert(input.end(), buf, buf + len);
+			buf += len;
+			size -= len;
+			if (input.size() == SAVE_BLOCK_SIZE) this->SubmitLastBlock();
+		}
+	}
+
+	void Finish() override
+	{
+		if (!this->blocks.empty() && this->blocks.back()->input.size() < SAVE_BLOCK_SIZE) this->SubmitLastBlock();
+		this->WriteCompletedBlocks(this->blocks.size());
+
+		uint32 end[2] = { 0, 0 };
+		this->chain->Write((byte *)end, sizeof(end));
+		this->chain->Finish();
+	}
+};
+
+/**
+ * Filter decompressing independent blocks in parallel.
+ * @tparam Tcodec Compressor, see #BlockSaveFilter.
+ */
+template <typename Tcodec>
+struct BlockLoadFilter : LoadFilter {
+	std::deque<std::unique_ptr<SaveLoadBlock>> blocks; ///< Blocks in file order which have been read but not yet completely passed on.
+	const size_t window;                               ///< Maximum number of blocks in flight.
+	bool end_of_stream = false;                        ///< Whether the end marker has been read.
+
+	/**
+	 * Initialise this filter.
+	 * @param chain The next filter in this chain.
+	 */
+	BlockLoadFilter(LoadFilter *chain) : LoadFilter(chain), window(GetSaveBlockWindow())
+	{
+	}
+
+	/** Read the next block from the chain, and start decompressing it. */
+	void ReadBlock()
+	{
+		uint32 header[2];
+		if (this->chain->Read((byte *)header, sizeof(header)) != sizeof(header)) SlError(STR_GAME_SAVELOAD_ERROR_FILE_NOT_READABLE, "Truncated block stream");
+
+		const size_t compressed_size = FROM_BE32(header[0]);
+		const size_t size = FROM_BE32(header[1]);
+		if (compressed_size == 0 && size == 0) {
+			this->end_of_stream = true;
+			return;
+		}
+		if (compressed_size == 0 || size == 0 || size > SAVE_BLOCK_MAX_SIZE || compressed_size > SAVE_BLOCK_MAX_SIZE * 2) SlErrorCorrupt("Invalid block size");
+
+		std::unique_ptr<SaveLoadBlock> block = std::make_unique<SaveLoadBlock>();
+		block->input.resize(compressed_size);
+		if (this->chain->Read(block->input.data(), compressed_size) != compressed_size) SlError(STR_GAME_SAVELOAD_ERROR_FILE_NOT_READABLE, "Truncated block stream");
+		block->output.resize(size);
+
+		SaveLoadBlock *b = block.get();
+		this->blocks.push_back(std::move(block));
+		b->task.Run([b]() {
+			b->failed = !Tcodec::Decompress(b->input.data(), b->input.size(), b->output.data(), b->output.size());
+		});
+	}
+
+	size_t Read(byte *buf, size_t size) override
+	{
+		size_t read = 0;
+		while (read < size) {
+			while (!this->end_of_stream && this->blocks.size() < this->window) this->ReadBlock();
+			if (this->blocks.empty()) break;
+
+			SaveLoadBlock &block = *this->blocks.front();
+			block.task.Wait();
+			if (block.failed) SlErrorCorrupt("Block decompression failed");
+
+			const size_t len = std::min(size - read, block.output.size() - block.read_offset);
+			memcpy(buf + read, block.output.data() + block.read_offset, len);
+			read += len;
+			block.read_offset += len;
+			if (block.read_offset == block.output.size()) this->blocks.pop_front();
+		}
+		return read;
+	}
+};
+
 /*******************************************
  ************* END OF CODE *****************
  *******************************************/
@@ -3007,6 +3364,7 @@ enum SaveLoadFormatFlags : byte {
 	SLF_NONE             = 0,
 	SLF_NO_THREADED_LOAD = 1 << 0, ///< Unsuitable for threaded loading
 	SLF_REQUIRES_ZSTD    = 1 << 1, ///< Automatic selection requires the zstd flag
+	SLF_NOT_DEFAULT      = 1 << 2, ///< Never selected automatically, only when explicitly configured
 };
 DECLARE_ENUM_AS_BIT_SET(SaveLoadFormatFlags);
 
@@ -3052,6 +3410,13 @@ static const SaveLoadFormat _saveload_formats[] = {
 #else
 	{"lzma",   TO_BE32X('OTTX'), nullptr,                            nullptr,                            0, 0, 0, SLF_NONE},
 #endif
+#if defined(WITH_LIBLZMA)
+	/* As lzma, but split into independently compressed blocks which are compressed and decompressed in parallel.
+	 * Savegames are slightly larger than with lzma, but compression scales with the number of cores. */
+	{"lzma-mt", TO_BE32X('OTXB'), CreateLoadFilter<BlockLoadFilter<LZMABlockCodec>>, CreateSaveFilter<BlockSaveFilter<LZMABlockCodec>>, 0, 2, 9, SLF_NOT_DEFAULT},
+#else
+	{"lzma-mt", TO_BE32X('OTXB'), nullptr,                           nullptr,                            0, 0, 0, SLF_NOT_DEFAULT},
+#endif
 #if defined(WITH_ZSTD)
 	/* Zstd provides a decent compression rate at a very high compression/decompression speed. Compared to lzma level 2
 	 * zstd saves are about 40% larger (on level 1) but it has about 30x faster compression and 5x decompression making it
@@ -3063,6 +3428,12 @@ static const SaveLoadFormat _saveload_formats[] = {
 #else
 	{"zstd",   TO_BE32X('OTTS'), nullptr,                            nullptr,                            0, 0, 0, SLF_REQUIRES_ZSTD},
 #endif
+#if defined(WITH_ZSTD)
+	/* As zstd, but split into independently compressed blocks which are compressed and decompressed in parallel. */
+	{"zstd-mt", TO_BE32X('OTSB'), CreateLoadFilter<BlockLoadFilter<ZSTDBlockCodec>>, CreateSaveFilter<BlockSaveFilter<ZSTDBlockCodec>>, 0, 101, 122, SLF_REQUIRES_ZSTD | SLF_NOT_DEFAULT},
+#else
+	{"zstd-mt", TO_BE32X('OTSB'), nullptr,                           nullptr,                            0, 0, 0, SLF_REQUIRES_ZSTD | SLF_NOT_DEFAULT},
+#endif
 };
 
 /**
@@ -3076,8 +3447,8 @@ static const SaveLoadFormat *GetSavegameFormat(const std::string &full_name, byt
 {
 	const SaveLoadFormat *def = lastof(_saveload_formats);
 
-	/* find default savegame format, the highest one with which files can be written */
-	while (!def->init_write || ((def->flags & SLF_REQUIRES_ZSTD) && !(flags & SMF_ZSTD_OK))) def--;
+	/* find default savegame format, the highest one with which files can be written and which may be selected automatically */
+	while (!def->init_write || (def->flags & SLF_NOT_DEFAULT) || ((def->flags & SLF_REQUIRES_ZSTD) && !(flags & SMF_ZSTD_OK))) def--;
 
 	if (!full_name.empty()) {
 		/* Get the ":..." of the compression level out of the way */
@@ -3214,7 +3585,12 @@ static SaveOrLoadResult SaveFileToDisk(bool threaded)
 		_sl.sf->Write((byte*)hdr, sizeof(hdr));
 
 		_sl.sf = fmt->init_write(_sl.sf, compression);
-		_sl.dumper->Flush(_sl.sf);
+		if (!_sl.dumper->Flush(_sl.sf)) {
+			/* Saving the chunks failed, this is reported by the main thread. */
+			ClearSaveLoadState();
+			if (threaded) SetAsyncSaveFinish(SaveFileDone);
+			return SL_ERROR;
+		}
 
 		ClearSaveLoadState();
 
@@ -3222,6 +3598,9 @@ static SaveOrLoadResult SaveFileToDisk(bool threaded)
 
 		return SL_OK;
 	} catch (...) {
+		/* Wait for the main thread to stop saving chunks to the dumper before it is deleted. */
+		if (_sl.dumper->queue != nullptr) _sl.dumper->queue->WriterFailed();
+
 		ClearSaveLoadState();
 
 		AsyncSaveFinishProc asfp = SaveFileDone;
@@ -3255,8 +3634,10 @@ void WaitTillSaved()
 
 /**
  * Actually perform the saving of the savegame.
- * General tactics is to first save the game to memory, then write it to file
- * using the writer, either in threaded mode if possible, or single-threaded.
+ * General tactics is to save the game to memory, and write it to file using the writer.
+ * In threaded mode, the savegame thread is started first and compresses and writes each completed block
+ * while the chunks are still being saved, the amount of data waiting to be written is limited by
+ * the threaded_save_buffer_limit setting. Otherwise the whole game is saved to memory before writing it.
  * @param writer   The filter to write the savegame to.
  * @param threaded Whether to try to perform the saving asynchronously.
  * @return Return the result of the action. #SL_OK or #SL_ERROR
@@ -3271,21 +3652,48 @@ static SaveOrLoadResult DoSave(SaveFilter *writer, bool threaded)
 	_sl_version = SAVEGAME_VERSION;
 	SlXvSetCurrentState();
 
+	if (threaded) {
+		const auto start = std::chrono::steady_clock::now();
+		SaveBlockQueue *queue = new SaveBlockQueue((size_t)_settings_client.gui.threaded_save_buffer_limit << 20);
+		_sl.dumper->queue = queue;
+		if (StartNewThread(&_save_thread, "ottd:savegame", &SaveFileToDisk, true)) {
+			SaveFileStart();
+			try {
+				SaveViewportBeforeSaveGame();
+				SlSaveChunks();
+			} catch (...) {
+				queue->Finish(true);
+				WaitTillSaved();
+				throw;
+			}
+
+			/* The dumper and its queue are deleted by the savegame thread once the queue has been finished. */
+			const size_t peak_queued_bytes = queue->peak_queued_bytes;
+			const auto wait_time = queue->wait_time;
+			const size_t total_bytes = _sl.dumper->GetSize();
+			_sl.dumper->FinishQueue();
+
+			DEBUG(sl, 2, "Saved chunks in %u ms (waiting for writer: %u ms), size: " PRINTF_SIZE " KiB, peak buffered: " PRINTF_SIZE " KiB",
+					(uint)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count(),
+					(uint)std::chrono::duration_cast<std::chrono::milliseconds>(wait_time).count(),
+					total_bytes >> 10, peak_queued_bytes >> 10);
+			return SL_OK;
+		}
+
+		DEBUG(sl, 1, "Cannot create savegame thread, reverting to single-threaded mode...");
+		delete _sl.dumper->queue;
+		_sl.dumper->queue = nullptr;
+	}
+
 	SaveViewportBeforeSaveGame();
 	SlSaveChunks();
 
 	SaveFileStart();
 
-	if (!threaded || !StartNewThread(&_save_thread, "ottd:savegame", &SaveFileToDisk, true)) {
-		if (threaded) DEBUG(sl, 1, "Cannot create savegame thread, reverting to single-threaded mode...");
-
-		SaveOrLoadResult result = SaveFileToDisk(false);
-		SaveFileDone();
-
-		return result;
-	}
+	SaveOrLoadResult result = SaveFileToDisk(false);
+	SaveFileDone();
 
-	return SL_OK;
+	return result;
 }
 
 /**
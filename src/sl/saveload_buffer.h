@@ -20,6 +20,7 @@
 
 struct LoadFilter;
 struct SaveFilter;
+struct SaveBlockQueue;
 
 /** Save in chunks of 128 KiB. */
 static const size_t MEMORY_CHUNK_SIZE = 128 * 1024;
@@ -159,6 +160,8 @@ struct MemoryDumper {
 	byte *saved_buf = nullptr;
 	byte *saved_bufe = nullptr;
 
+	SaveBlockQueue *queue = nullptr;        ///< If not nullptr, completed blocks are passed to this queue instead of being kept, owned by the dumper.
+
 	MemoryDumper()
 	{
 		const size_t size = 8192;
@@ -166,10 +169,7 @@ struct MemoryDumper {
 		this->autolen_buf_end = this->autolen_buf + size;
 	}
 
-	~MemoryDumper()
-	{
-		free(this->autolen_buf);
-	}
+	~MemoryDumper();
 
 	static MemoryDumper *GetCurrent();
 
@@ -255,7 +255,8 @@ struct MemoryDumper {
 		this->buf += 8;
 	}
 
-	void Flush(SaveFilter *writer);
+	bool Flush(SaveFilter *writer);
+	void FinishQueue();
 	size_t GetSize() const;
 	void StartAutoLength();
 	std::pair<byte *, size_t> StopAutoLength();
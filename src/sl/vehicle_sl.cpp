@@ -529,6 +529,8 @@ void AfterLoadVehicles(bool part_of_load)
 		v->UpdateViewport(false);
 		v->cargo.AssertCountConsistency();
 	}
+
+	CheckVehicleTileHashSize();
 }
 
 void AfterLoadVehiclesRemoveAnyFoundInvalid()
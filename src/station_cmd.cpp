@@ -47,6 +47,7 @@
 #include "debug.h"
 #include "core/random_func.hpp"
 #include "core/container_func.hpp"
+#include "core/checksum_func.hpp"
 #include "company_base.h"
 #include "table/airporttile_ids.h"
 #include "newgrf_airporttiles.h"
@@ -4364,6 +4365,14 @@ static void UpdateStationRating(Station *st)
 		}
 	}
 
+	if (_networking) {
+		for (const CargoSpec *cs : CargoSpec::Iterate()) {
+			const GoodsEntry *ge = &st->goods[cs->Index()];
+			if (!ge->HasRating()) continue;
+			UpdateStateChecksum((((uint64) st->index) << 40) | (((uint64) cs->Index()) << 32) | (((uint64) ge->rating) << 24) | std::min<uint>(ge->cargo.TotalCount(), 0xFFFFFF), SCS_STATIONS);
+		}
+	}
+
 	StationID index = st->index;
 
 	if (waiting_changed) {
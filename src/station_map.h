@@ -516,6 +516,7 @@ static inline void SetRailStationReservation(TileIndex t, bool b)
 {
 	dbg_assert_tile(HasStationRail(t), t);
 	SB(_me[t].m6, 2, 1, b ? 1 : 0);
+	NotifyRailStateChange(t);
 }
 
 /**
@@ -32,7 +32,7 @@ debug_inline static uint TileHeight(TileIndex tile)
 #ifdef _DEBUG
 	dbg_assert_msg(tile < MapSize(), "tile: 0x%X, size: 0x%X", tile, MapSize());
 #endif
-	return _m[tile].height;
+	return TileHeightByte(tile);
 }
 
 /**
@@ -61,7 +61,7 @@ static inline void SetTileHeight(TileIndex tile, uint height)
 {
 	dbg_assert_msg(tile < MapSize(), "tile: 0x%X, size: 0x%X", tile, MapSize());
 	dbg_assert(height <= MAX_TILE_HEIGHT);
-	_m[tile].height = height;
+	TileHeightByte(tile) = height;
 }
 
 /**
@@ -102,7 +102,7 @@ debug_inline static TileType GetTileType(TileIndex tile)
 #ifdef _DEBUG
 	dbg_assert_msg(tile < MapSize(), "tile: 0x%X, size: 0x%X", tile, MapSize());
 #endif
-	return (TileType)GB(_m[tile].type, 4, 4);
+	return (TileType)GB(TileTypeByte(tile), 4, 4);
 }
 
 /**
@@ -141,7 +141,7 @@ static inline void SetTileType(TileIndex tile, TileType type)
 	 * edges of the map. If _settings_game.construction.freeform_edges is true,
 	 * the upper edges of the map are also VOID tiles. */
 	dbg_assert_msg(IsInnerTile(tile) == (type != MP_VOID), "tile: 0x%X (%d), type: %d", tile, IsInnerTile(tile), type);
-	SB(_m[tile].type, 4, 4, type);
+	SB(TileTypeByte(tile), 4, 4, type);
 }
 
 /**
@@ -230,7 +230,7 @@ static inline void SetTropicZone(TileIndex tile, TropicZone type)
 {
 	dbg_assert_msg(tile < MapSize(), "tile: 0x%X, size: 0x%X, type: %d", tile, MapSize(), type);
 	dbg_assert_msg(!IsTileType(tile, MP_VOID) || type == TROPICZONE_NORMAL, "tile: 0x%X (%d), type: %d", tile, GetTileType(tile), type);
-	SB(_m[tile].type, 0, 2, type);
+	SB(TileTypeByte(tile), 0, 2, type);
 }
 
 /**
@@ -242,7 +242,7 @@ static inline void SetTropicZone(TileIndex tile, TropicZone type)
 static inline TropicZone GetTropicZone(TileIndex tile)
 {
 	dbg_assert_msg(tile < MapSize(), "tile: 0x%X, size: 0x%X", tile, MapSize());
-	return (TropicZone)GB(_m[tile].type, 0, 2);
+	return (TropicZone)GB(TileTypeByte(tile), 0, 2);
 }
 
 /**
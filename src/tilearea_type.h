@@ -227,6 +227,9 @@ public:
 	OrthogonalPrefetchTileIterator(const TileArea &ta) : tile(ta.w == 0 || ta.h == 0 ? INVALID_TILE : ta.tile), w(ta.w), x(ta.w), y(ta.h)
 	{
 		PREFETCH_NTA(&_m[ta.tile]);
+#ifdef WITH_SPLIT_MAP_ARRAYS
+		PREFETCH_NTA(&_m_type[ta.tile]);
+#endif
 	}
 
 	/**
@@ -251,6 +254,9 @@ public:
 			this->x = this->w;
 			this->tile += TileDiffXY(1, 1) - this->w;
 			PREFETCH_NTA(&_m[tile]);
+#ifdef WITH_SPLIT_MAP_ARRAYS
+			PREFETCH_NTA(&_m_type[tile]);
+#endif
 		} else {
 			this->tile = INVALID_TILE;
 		}
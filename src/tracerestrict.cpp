@@ -238,20 +238,52 @@ static bool TestStationCondition(StationID station, TraceRestrictItem item)
 
 }
 
+/**
+ * Get the next goto order after the train's current order
+ * @return next goto order, or nullptr if there is none
+ */
+static const Order *GetTraceRestrictNextGotoOrder(const Train *v)
+{
+	if (v->orders == nullptr) return nullptr;
+	if (v->orders->GetNumOrders() == 0) return nullptr;
+
+	const Order *current_order = v->GetOrder(v->cur_real_order_index);
+	for (const Order *order = v->orders->GetNext(current_order); order != current_order; order = v->orders->GetNext(order)) {
+		if (order->IsGotoOrder()) return order;
+	}
+	return nullptr;
+}
+
 /**
  * Execute program on train and store results in out
  * @p v may not be nullptr
  * @p out should be zero-initialised
+ * @p actions_filter actions which the caller is interested in, the results of other actions may be incomplete
  */
-void TraceRestrictProgram::Execute(const Train* v, const TraceRestrictProgramInput &input, TraceRestrictProgramResult& out) const
+void TraceRestrictProgram::Execute(const Train* v, const TraceRestrictProgramInput &input, TraceRestrictProgramResult& out, TraceRestrictProgramActionsUsedFlags actions_filter) const
 {
 	// static to avoid needing to re-alloc/resize on each execution
 	static std::vector<TraceRestrictCondStackFlags> condstack;
 	condstack.clear();
 
+	dbg_assert(this->compiled.size() == this->items.size());
+
+	/* Slot and counter operations have side effects, do not skip anything when these are permitted */
+	if (input.permitted_slot_operations != 0) actions_filter = TRPAUF_ALL;
+
 	byte have_previous_signal = 0;
 	TileIndex previous_signal_tile[3];
 
+	bool have_next_order = false;
+	const Order *next_order = nullptr;
+	auto get_next_order = [&]() -> const Order * {
+		if (!have_next_order) {
+			next_order = GetTraceRestrictNextGotoOrder(v);
+			have_next_order = true;
+		}
+		return next_order;
+	};
+
 	size_t size = this->items.size();
 	for (size_t i = 0; i < size; i++) {
 		TraceRestrictItem item = this->items[i];
@@ -260,6 +292,21 @@ void TraceRestrictProgram::Execute(const Train* v, const TraceRestrictProgramInp
 		if (IsTraceRestrictConditional(item)) {
 			TraceRestrictCondFlags condflags = GetTraceRestrictCondFlags(item);
 			TraceRestrictCondOp condop = GetTraceRestrictCondOp(item);
+			const TraceRestrictCompiledItem &compiled = this->compiled[i];
+
+			if (condflags & (TRCF_OR | TRCF_ELSE)) {
+				assert(!condstack.empty());
+				if ((condflags & TRCF_OR) && (condstack.back() & TRCSF_ACTIVE)) {
+					/* orif on an active branch leaves it active, the condition does not need to be evaluated */
+					if (IsTraceRestrictDoubleItem(item)) i++;
+					continue;
+				}
+				if (condstack.back() & (TRCSF_DONE_IF | TRCSF_PARENT_INACTIVE)) {
+					/* No later branch of this block can become active, jump to the end if */
+					i = compiled.block_end - 1;
+					continue;
+				}
+			}
 
 			if (type == TRIT_COND_ENDIF) {
 				assert(!condstack.empty());
@@ -273,6 +320,20 @@ void TraceRestrictProgram::Execute(const Train* v, const TraceRestrictProgramInp
 					condstack.pop_back();
 				}
 			} else {
+				if (!(condflags & (TRCF_OR | TRCF_ELSE))) {
+					/* Skip the whole block if the parent is inactive, or the block contains no actions of interest */
+					if ((!condstack.empty() && !(condstack.back() & TRCSF_ACTIVE)) || !(compiled.block_actions & actions_filter)) {
+						i = compiled.block_end;
+						continue;
+					}
+				}
+
+				if (compiled.const_result != TRCCR_NONE) {
+					if (IsTraceRestrictDoubleItem(item)) i++;
+					HandleCondition(condstack, condflags, compiled.const_result == TRCCR_TRUE);
+					continue;
+				}
+
 				uint16 condvalue = GetTraceRestrictValue(item);
 				bool result = false;
 				switch(type) {
@@ -293,16 +354,8 @@ void TraceRestrictProgram::Execute(const Train* v, const TraceRestrictProgramInp
 						break;
 
 					case TRIT_COND_NEXT_ORDER: {
-						if (v->orders == nullptr) break;
-						if (v->orders->GetNumOrders() == 0) break;
-
-						const Order *current_order = v->GetOrder(v->cur_real_order_index);
-						for (const Order *order = v->orders->GetNext(current_order); order != current_order; order = v->orders->GetNext(order)) {
-							if (order->IsGotoOrder()) {
-								result = TestOrderCondition(order, item);
-								break;
-							}
-						}
+						const Order *order = get_next_order();
+						if (order != nullptr) result = TestOrderCondition(order, item);
 						break;
 					}
 
@@ -592,16 +645,7 @@ void TraceRestrictProgram::Execute(const Train* v, const TraceRestrictProgramInp
 								break;
 
 							case TRTDCAF_NEXT_ORDER:
-								if (v->orders == nullptr) break;
-								if (v->orders->GetNumOrders() == 0) break;
-
-								const Order *current_order = v->GetOrder(v->cur_real_order_index);
-								for (const Order *order = v->orders->GetNext(current_order); order != current_order; order = v->orders->GetNext(order)) {
-									if (order->IsGotoOrder()) {
-										o = order;
-										break;
-									}
-								}
+								o = get_next_order();
 								break;
 						}
 
@@ -886,6 +930,170 @@ void TraceRestrictProgram::Execute(const Train* v, const TraceRestrictProgramInp
 	assert(condstack.empty());
 }
 
+/**
+ * Get the actions which may be performed by an action item, for the purposes of TraceRestrictProgram::Compile
+ * Unlike Validate, this does not consider whether the action is conditional or later cancelled
+ */
+static TraceRestrictProgramActionsUsedFlags GetTraceRestrictActionItemFlags(TraceRestrictItem item)
+{
+	switch (GetTraceRestrictType(item)) {
+		case TRIT_PF_DENY:
+		case TRIT_PF_PENALTY:
+			return TRPAUF_PF;
+
+		case TRIT_RESERVE_THROUGH:
+			return TRPAUF_RESERVE_THROUGH | TRPAUF_RESERVE_THROUGH_ALWAYS;
+
+		case TRIT_LONG_RESERVE:
+			return TRPAUF_LONG_RESERVE;
+
+		case TRIT_WAIT_AT_PBS:
+			return TRPAUF_WAIT_AT_PBS | TRPAUF_PBS_RES_END_WAIT;
+
+		case TRIT_SLOT:
+			return TRPAUF_SLOT_ACQUIRE | TRPAUF_SLOT_RELEASE_BACK | TRPAUF_SLOT_RELEASE_FRONT | TRPAUF_SLOT_ACQUIRE_ON_RES |
+					TRPAUF_PBS_RES_END_SLOT | TRPAUF_PBS_RES_END_WAIT | TRPAUF_WAIT_AT_PBS;
+
+		case TRIT_REVERSE:
+			return TRPAUF_REVERSE;
+
+		case TRIT_SPEED_RESTRICTION:
+			return TRPAUF_SPEED_RESTRICTION;
+
+		case TRIT_NEWS_CONTROL:
+			return TRPAUF_TRAIN_NOT_STUCK;
+
+		case TRIT_COUNTER:
+			return TRPAUF_CHANGE_COUNTER;
+
+		case TRIT_PF_PENALTY_CONTROL:
+			return TRPAUF_NO_PBS_BACK_PENALTY;
+
+		case TRIT_SPEED_ADAPTATION_CONTROL:
+			return TRPAUF_SPEED_ADAPTATION;
+
+		case TRIT_SIGNAL_MODE_CONTROL:
+			return TRPAUF_CMB_SIGNAL_MODE_CTRL;
+
+		default:
+			return TRPAUF_ALL;
+	}
+}
+
+/**
+ * Try to constant fold a condition item
+ * @param item condition item
+ * @param value value slot of double items, if applicable
+ * @return constant folded result, or TRCCR_NONE
+ */
+static TraceRestrictCompiledConstResult FoldTraceRestrictCondition(TraceRestrictItem item, uint32 value)
+{
+	auto binary_result = [&](bool input) -> TraceRestrictCompiledConstResult {
+		return TestBinaryConditionCommon(item, input) ? TRCCR_TRUE : TRCCR_FALSE;
+	};
+
+	switch (GetTraceRestrictType(item)) {
+		case TRIT_COND_UNDEFINED:
+			return TRCCR_FALSE;
+
+		case TRIT_COND_PBS_ENTRY_SIGNAL:
+			if (value == INVALID_TILE) return binary_result(false);
+			break;
+
+		case TRIT_COND_TRAIN_LENGTH:
+		case TRIT_COND_MAX_SPEED:
+		case TRIT_COND_LOAD_PERCENT:
+		case TRIT_COND_RESERVED_TILES:
+		case TRIT_COND_PHYS_RATIO:
+			/* These inputs are never negative */
+			if (GetTraceRestrictValue(item) == 0) {
+				if (GetTraceRestrictCondOp(item) == TRCO_GTE) return TRCCR_TRUE;
+				if (GetTraceRestrictCondOp(item) == TRCO_LT) return TRCCR_FALSE;
+			}
+			break;
+
+		default:
+			break;
+	}
+	return TRCCR_NONE;
+}
+
+/**
+ * Generate the precomputed execution data for the current program instruction list
+ * This must be called whenever the structure of the instruction list changes, in-place value changes are OK
+ */
+void TraceRestrictProgram::Compile()
+{
+	const size_t size = this->items.size();
+	this->compiled.assign(size, TraceRestrictCompiledItem());
+	this->has_dynamic_conditions = false;
+
+	struct OpenBlock {
+		size_t start;                                        ///< Array offset of the if
+		TraceRestrictProgramActionsUsedFlags actions;        ///< Actions present in the block so far
+	};
+	std::vector<OpenBlock> blocks;
+	std::vector<size_t> branches; // array offsets of if/elif/orif/else instructions of all open blocks
+
+	auto add_actions = [&](TraceRestrictProgramActionsUsedFlags actions) {
+		if (!blocks.empty()) blocks.back().actions |= actions;
+	};
+	auto close_block = [&](size_t end) {
+		const OpenBlock block = blocks.back();
+		blocks.pop_back();
+		while (!branches.empty() && branches.back() >= block.start) {
+			this->compiled[branches.back()].block_end = (uint32)end;
+			branches.pop_back();
+		}
+		this->compiled[block.start].block_actions = block.actions;
+		add_actions(block.actions);
+	};
+
+	for (size_t i = 0; i < size; i++) {
+		const TraceRestrictItem item = this->items[i];
+		const size_t offset = i;
+		uint32 value = 0;
+		if (IsTraceRestrictDoubleItem(item)) {
+			i++;
+			if (i < size) value = this->items[i];
+		}
+
+		if (!IsTraceRestrictConditional(item)) {
+			add_actions(GetTraceRestrictActionItemFlags(item));
+			continue;
+		}
+
+		const TraceRestrictCondFlags condflags = GetTraceRestrictCondFlags(item);
+		if (GetTraceRestrictType(item) == TRIT_COND_ENDIF) {
+			if (blocks.empty()) continue;
+			if (condflags & TRCF_ELSE) {
+				branches.push_back(offset);
+			} else {
+				close_block(offset);
+			}
+			continue;
+		}
+
+		this->compiled[offset].const_result = FoldTraceRestrictCondition(item, value);
+		if (this->compiled[offset].const_result == TRCCR_NONE) this->has_dynamic_conditions = true;
+		if (condflags & (TRCF_OR | TRCF_ELSE)) {
+			if (!blocks.empty()) branches.push_back(offset);
+		} else {
+			blocks.push_back({ offset, static_cast<TraceRestrictProgramActionsUsedFlags>(0) });
+			branches.push_back(offset);
+		}
+	}
+
+	/* Invalid programs only: blocks which are not closed extend to the end of the program */
+	while (!blocks.empty()) {
+		blocks.back().actions = TRPAUF_ALL;
+		close_block(size);
+	}
+
+	/* Routes cached by the rail pathfinder may depend on the previous contents of this program */
+	YapfFlushRailRouteCache();
+}
+
 void TraceRestrictProgram::ClearRefIds()
 {
 	if (this->refcount > 4) free(this->ref_ids.ptr_ref_ids.buffer);
@@ -2185,6 +2393,7 @@ CommandCost CmdProgramSignalTraceRestrict(TileIndex tile, DoCommandFlag flags, u
 		// move in modified program
 		prog->items.swap(items);
 		prog->actions_used_flags = actions_used_flags;
+		prog->Compile();
 
 		if (prog->items.size() == 0 && prog->refcount == 1) {
 			// program is empty, and this tile is the only reference to it
@@ -448,6 +448,8 @@ enum TraceRestrictProgramActionsUsedFlags {
 	TRPAUF_RESERVE_THROUGH_ALWAYS = 1 << 17, ///< Reserve through action is unconditionally set
 	TRPAUF_CMB_SIGNAL_MODE_CTRL   = 1 << 18, ///< Combined normal/shunt signal mode control
 	TRPAUF_ORDER_CONDITIONALS     = 1 << 19, ///< Order conditionals are present
+
+	TRPAUF_ALL                    = (TRPAUF_ORDER_CONDITIONALS << 1) - 1, ///< All of the above
 };
 DECLARE_ENUM_AS_BIT_SET(TraceRestrictProgramActionsUsedFlags)
 
@@ -495,14 +497,35 @@ struct TraceRestrictProgramResult {
 			: penalty(0), flags(static_cast<TraceRestrictProgramResultFlags>(0)) { }
 };
 
+/**
+ * Constant folded result of a conditional instruction, see TraceRestrictCompiledItem
+ */
+enum TraceRestrictCompiledConstResult : uint8 {
+	TRCCR_NONE                    = 0,       ///< Condition must be evaluated at execution time
+	TRCCR_FALSE                   = 1,       ///< Condition is always false
+	TRCCR_TRUE                    = 2,       ///< Condition is always true
+};
+
+/**
+ * Precomputed execution data for an item of a TraceRestrictProgram, indexed by array offset
+ * This is generated by TraceRestrictProgram::Compile and is not saved
+ */
+struct TraceRestrictCompiledItem {
+	uint32 block_end = 0;                                ///< For if/elif/orif/else: array offset of the matching end if
+	TraceRestrictProgramActionsUsedFlags block_actions = static_cast<TraceRestrictProgramActionsUsedFlags>(0); ///< For if: actions present anywhere in the if/end if block
+	TraceRestrictCompiledConstResult const_result = TRCCR_NONE; ///< For conditions: constant folded result
+};
+
 /**
  * Program type, this stores the instruction list
  * This is refcounted, see info at top of tracerestrict.cpp
  */
 struct TraceRestrictProgram : TraceRestrictProgramPool::PoolItem<&_tracerestrictprogram_pool> {
 	std::vector<TraceRestrictItem> items;
+	std::vector<TraceRestrictCompiledItem> compiled;   ///< NOSAVE: Precomputed execution data for items, see Compile
 	uint32 refcount;
 	TraceRestrictProgramActionsUsedFlags actions_used_flags;
+	bool has_dynamic_conditions;                       ///< NOSAVE: Whether any conditional could not be constant folded, see Compile
 
 private:
 
@@ -527,14 +550,16 @@ private:
 public:
 
 	TraceRestrictProgram()
-			: refcount(0), actions_used_flags(static_cast<TraceRestrictProgramActionsUsedFlags>(0)) { }
+			: refcount(0), actions_used_flags(static_cast<TraceRestrictProgramActionsUsedFlags>(0)), has_dynamic_conditions(false) { }
 
 	~TraceRestrictProgram()
 	{
 		this->ClearRefIds();
 	}
 
-	void Execute(const Train *v, const TraceRestrictProgramInput &input, TraceRestrictProgramResult &out) const;
+	void Execute(const Train *v, const TraceRestrictProgramInput &input, TraceRestrictProgramResult &out, TraceRestrictProgramActionsUsedFlags actions_filter = TRPAUF_ALL) const;
+
+	void Compile();
 
 	inline const TraceRestrictRefId *GetRefIdsPtr() const { return const_cast<TraceRestrictProgram *>(this)->GetRefIdsPtr(); }
 
@@ -584,10 +609,12 @@ public:
 		return items.begin() + TraceRestrictProgram::InstructionOffsetToArrayOffset(items, instruction_offset);
 	}
 
-	/** Call validation function on current program instruction list and set actions_used_flags */
+	/** Call validation function on current program instruction list, set actions_used_flags and compile */
 	CommandCost Validate()
 	{
-		return TraceRestrictProgram::Validate(items, actions_used_flags);
+		CommandCost result = TraceRestrictProgram::Validate(items, actions_used_flags);
+		this->Compile();
+		return result;
 	}
 };
 
@@ -85,6 +85,7 @@ static inline void SetTunnelReservation(TileIndex t, bool b)
 {
 	dbg_assert_tile(IsRailTunnelTile(t), t);
 	SB(_m[t].m5, 4, 1, b ? 1 : 0);
+	NotifyRailStateChange(t);
 }
 
 TileIndex GetOtherTunnelEnd(TileIndex);
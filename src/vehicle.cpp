@@ -60,12 +60,15 @@
 #include "string_func.h"
 #include "scope_info.h"
 #include "debug_settings.h"
+#include "pathfinder/yapf/yapf.h"
 #include "3rdparty/cpp-btree/btree_set.h"
 #include "3rdparty/cpp-btree/btree_map.h"
 
 #include "table/strings.h"
 
 #include <algorithm>
+#include <chrono>
+#include <map>
 
 #include "safeguards.h"
 
@@ -451,35 +454,124 @@ Vehicle::Vehicle(VehicleType type)
 	this->last_loading_station = INVALID_STATION;
 	this->last_loading_tick = 0;
 	this->cur_image_valid_dir  = INVALID_DIR;
+	this->hash_tile_current = INVALID_TILE;
 	this->vcache.cached_veh_flags = 0;
 }
 
-/* Size of the hash, 6 = 64 x 64, 7 = 128 x 128. Larger sizes will (in theory) reduce hash
- * lookup times at the expense of memory usage. */
-const int HASH_BITS = 7;
-const int HASH_SIZE = 1 << HASH_BITS;
-const int HASH_MASK = HASH_SIZE - 1;
-const int TOTAL_HASH_SIZE = 1 << (HASH_BITS * 2);
-const int TOTAL_HASH_MASK = TOTAL_HASH_SIZE - 1;
+/*
+ * The vehicle tile hash maps a tile and vehicle type to a chain of the vehicles on that tile.
+ * The keys are hashed into a table of buckets, which is sized from the number of vehicles in the hash instead of from the map
+ * size, so the chains stay short on any map size and for any vehicle density. Queries filter the chains on the tile.
+ * A bitmap with one bit per bucket allows empty buckets to be skipped without touching the bucket array.
+ * The relative order of the vehicles on a tile does not depend on the size of the table.
+ */
+
+/** Log2 of the minimum number of buckets of the vehicle tile hash. */
+static const uint VEHICLE_TILE_HASH_MIN_BITS = 10;
 
-/* Resolution of the hash, 0 = 1*1 tile, 1 = 2*2 tiles, 2 = 4*4 tiles, etc.
- * Profiling results show that 0 is fastest. */
-const int HASH_RES = 0;
+struct VehicleTileHash {
+	uint bits = 0;                           ///< Log2 of the number of buckets.
+	uint count = 0;                          ///< Number of vehicles in the hash.
+	std::vector<Vehicle *> buckets;          ///< Vehicle chain heads.
+	std::vector<uint64> occupancy;           ///< Bitmap of non-empty buckets, indexed as #buckets.
+
+	VehicleTileHash()
+	{
+		this->Reset();
+	}
+
+	inline uint Index(TileIndex tile, VehicleType type) const
+	{
+		/* Fibonacci hashing, neighbouring tiles are spread over the table */
+		return ((((uint32)tile << 2) | type) * 0x9E3779B9U) >> (32 - this->bits);
+	}
+
+	inline bool IsOccupied(uint index) const
+	{
+		return HasBit(this->occupancy[index / 64], index % 64);
+	}
+
+	inline void Link(Vehicle *v, uint index)
+	{
+		Vehicle **head = &this->buckets[index];
+		v->hash_tile_next = *head;
+		if (v->hash_tile_next != nullptr) v->hash_tile_next->hash_tile_prev = &v->hash_tile_next;
+		v->hash_tile_prev = head;
+		*head = v;
+		SetBit(this->occupancy[index / 64], index % 64);
+	}
+
+	inline void Unlink(Vehicle *v, uint index)
+	{
+		if (v->hash_tile_next != nullptr) v->hash_tile_next->hash_tile_prev = v->hash_tile_prev;
+		*v->hash_tile_prev = v->hash_tile_next;
+		if (this->buckets[index] == nullptr) ClrBit(this->occupancy[index / 64], index % 64);
+	}
 
-static Vehicle *_vehicle_tile_hash[TOTAL_HASH_SIZE * 4];
+	/**
+	 * Get the table size for a number of vehicles: between 2 and 4 buckets per vehicle.
+	 * @param count Number of vehicles.
+	 * @return Log2 of the number of buckets.
+	 */
+	static uint WantedBits(uint count)
+	{
+		return std::max<uint>(VEHICLE_TILE_HASH_MIN_BITS, FindLastBit(count) + 2);
+	}
+
+	void Rebuild(uint bits)
+	{
+		std::vector<Vehicle *> vehicles;
+		vehicles.reserve(this->count);
+		for (Vehicle *head : this->buckets) {
+			for (Vehicle *v = head; v != nullptr; v = v->hash_tile_next) vehicles.push_back(v);
+		}
+
+		this->bits = bits;
+		this->buckets.assign((size_t)1 << bits, nullptr);
+		this->occupancy.assign(CeilDiv(1 << bits, 64), 0);
+
+		/* Insert in reverse order, so that the vehicles of each old chain, and hence of each tile, keep their relative order */
+		for (auto it = vehicles.rbegin(); it != vehicles.rend(); ++it) {
+			this->Link(*it, this->Index((*it)->hash_tile_current, (*it)->type));
+		}
+	}
+
+	/**
+	 * Resize the table if the number of vehicles in it has changed too much.
+	 * This must not be called while a chain is being iterated.
+	 */
+	void CheckSize()
+	{
+		const uint wanted = WantedBits(this->count);
+		if (wanted > this->bits || wanted + 2 < this->bits) this->Rebuild(wanted);
+	}
+
+	void Reset()
+	{
+		this->bits = VEHICLE_TILE_HASH_MIN_BITS;
+		this->count = 0;
+		this->buckets.assign(1 << this->bits, nullptr);
+		this->occupancy.assign(CeilDiv(1 << this->bits, 64), 0);
+	}
+};
 
-static Vehicle *VehicleFromTileHash(int xl, int yl, int xu, int yu, VehicleType type, void *data, VehicleFromPosProc *proc, bool find_first)
+static VehicleTileHash _vehicle_tile_hash;
+
+static Vehicle *VehicleFromTileHash(uint xl, uint yl, uint xu, uint yu, VehicleType type, void *data, VehicleFromPosProc *proc, bool find_first)
 {
-	for (int y = yl; ; y = (y + (1 << HASH_BITS)) & (HASH_MASK << HASH_BITS)) {
-		for (int x = xl; ; x = (x + 1) & HASH_MASK) {
-			Vehicle *v = _vehicle_tile_hash[((x + y) & TOTAL_HASH_MASK) + (TOTAL_HASH_SIZE * type)];
-			for (; v != nullptr; v = v->hash_tile_next) {
+	for (uint y = yl; y <= yu; y++) {
+		for (uint x = xl; x <= xu; x++) {
+			const TileIndex tile = TileXY(x, y);
+			const uint index = _vehicle_tile_hash.Index(tile, type);
+			if (!_vehicle_tile_hash.IsOccupied(index)) continue;
+
+			for (Vehicle *v = _vehicle_tile_hash.buckets[index]; v != nullptr; v = v->hash_tile_next) {
+				if (v->hash_tile_current != tile) continue;
+
 				Vehicle *a = proc(v, data);
 				if (find_first && a != nullptr) return a;
 			}
-			if (x == xu) break;
 		}
-		if (y == yu) break;
 	}
 
 	return nullptr;
@@ -502,10 +594,10 @@ Vehicle *VehicleFromPosXY(int x, int y, VehicleType type, void *data, VehicleFro
 	const int COLL_DIST = 6;
 
 	/* Hash area to scan is from xl,yl to xu,yu */
-	int xl = GB((x - COLL_DIST) / TILE_SIZE, HASH_RES, HASH_BITS);
-	int xu = GB((x + COLL_DIST) / TILE_SIZE, HASH_RES, HASH_BITS);
-	int yl = GB((y - COLL_DIST) / TILE_SIZE, HASH_RES, HASH_BITS) << HASH_BITS;
-	int yu = GB((y + COLL_DIST) / TILE_SIZE, HASH_RES, HASH_BITS) << HASH_BITS;
+	uint xl = std::min<uint>(std::max<int>(0, (x - COLL_DIST) / (int)TILE_SIZE), MapMaxX());
+	uint xu = std::min<uint>(std::max<int>(0, (x + COLL_DIST) / (int)TILE_SIZE), MapMaxX());
+	uint yl = std::min<uint>(std::max<int>(0, (y - COLL_DIST) / (int)TILE_SIZE), MapMaxY());
+	uint yu = std::min<uint>(std::max<int>(0, (y + COLL_DIST) / (int)TILE_SIZE), MapMaxY());
 
 	return VehicleFromTileHash(xl, yl, xu, yu, type, data, proc, find_first);
 }
@@ -522,11 +614,10 @@ Vehicle *VehicleFromPosXY(int x, int y, VehicleType type, void *data, VehicleFro
  */
 Vehicle *VehicleFromPos(TileIndex tile, VehicleType type, void *data, VehicleFromPosProc *proc, bool find_first)
 {
-	int x = GB(TileX(tile), HASH_RES, HASH_BITS);
-	int y = GB(TileY(tile), HASH_RES, HASH_BITS) << HASH_BITS;
+	const uint index = _vehicle_tile_hash.Index(tile, type);
+	if (!_vehicle_tile_hash.IsOccupied(index)) return nullptr;
 
-	Vehicle *v = _vehicle_tile_hash[((x + y) & TOTAL_HASH_MASK) + (TOTAL_HASH_SIZE * type)];
-	for (; v != nullptr; v = v->hash_tile_next) {
+	for (Vehicle *v = _vehicle_tile_hash.buckets[index]; v != nullptr; v = v->hash_tile_next) {
 		if (v->tile != tile) continue;
 
 		Vehicle *a = proc(v, data);
@@ -823,35 +914,31 @@ CommandCost EnsureNoTrainOnTrackBits(TileIndex tile, TrackBits track_bits)
 
 void UpdateVehicleTileHash(Vehicle *v, bool remove)
 {
-	Vehicle **old_hash = v->hash_tile_current;
-	Vehicle **new_hash;
+	TileIndex old_tile = v->hash_tile_current;
+	TileIndex new_tile;
 
 	if (remove || HasBit(v->subtype, GVSF_VIRTUAL) || (v->tile == 0 && _settings_game.construction.freeform_edges)) {
-		new_hash = nullptr;
+		new_tile = INVALID_TILE;
 	} else {
-		int x = GB(TileX(v->tile), HASH_RES, HASH_BITS);
-		int y = GB(TileY(v->tile), HASH_RES, HASH_BITS) << HASH_BITS;
-		new_hash = &_vehicle_tile_hash[((x + y) & TOTAL_HASH_MASK) + (TOTAL_HASH_SIZE * v->type)];
+		new_tile = v->tile;
 	}
 
-	if (old_hash == new_hash) return;
+	if (old_tile == new_tile) return;
 
 	/* Remove from the old position in the hash table */
-	if (old_hash != nullptr) {
-		if (v->hash_tile_next != nullptr) v->hash_tile_next->hash_tile_prev = v->hash_tile_prev;
-		*v->hash_tile_prev = v->hash_tile_next;
+	if (old_tile != INVALID_TILE) {
+		_vehicle_tile_hash.Unlink(v, _vehicle_tile_hash.Index(old_tile, v->type));
+		_vehicle_tile_hash.count--;
 	}
 
 	/* Insert vehicle at beginning of the new position in the hash table */
-	if (new_hash != nullptr) {
-		v->hash_tile_next = *new_hash;
-		if (v->hash_tile_next != nullptr) v->hash_tile_next->hash_tile_prev = &v->hash_tile_next;
-		v->hash_tile_prev = new_hash;
-		*new_hash = v;
+	if (new_tile != INVALID_TILE) {
+		_vehicle_tile_hash.Link(v, _vehicle_tile_hash.Index(new_tile, v->type));
+		_vehicle_tile_hash.count++;
 	}
 
 	/* Remember current hash position */
-	v->hash_tile_current = new_hash;
+	v->hash_tile_current = new_tile;
 }
 
 bool ValidateVehicleTileHash(const Vehicle *v)
@@ -860,12 +947,14 @@ bool ValidateVehicleTileHash(const Vehicle *v)
 			|| (v->type == VEH_SHIP && HasBit(v->subtype, GVSF_VIRTUAL))
 			|| (v->type == VEH_AIRCRAFT && v->tile == 0 && _settings_game.construction.freeform_edges)
 			|| v->type >= VEH_COMPANY_END) {
-		return v->hash_tile_current == nullptr;
+		return v->hash_tile_current == INVALID_TILE;
 	}
 
-	int x = GB(TileX(v->tile), HASH_RES, HASH_BITS);
-	int y = GB(TileY(v->tile), HASH_RES, HASH_BITS) << HASH_BITS;
-	return v->hash_tile_current == &_vehicle_tile_hash[((x + y) & TOTAL_HASH_MASK) + (TOTAL_HASH_SIZE * v->type)];
+	if (v->hash_tile_current != v->tile || !_vehicle_tile_hash.IsOccupied(_vehicle_tile_hash.Index(v->tile, v->type))) return false;
+	for (const Vehicle *u = _vehicle_tile_hash.buckets[_vehicle_tile_hash.Index(v->tile, v->type)]; u != nullptr; u = u->hash_tile_next) {
+		if (u == v) return true;
+	}
+	return false;
 }
 
 static Vehicle *_vehicle_viewport_hash[1 << (GEN_HASHX_BITS + GEN_HASHY_BITS)];
@@ -941,9 +1030,18 @@ static void ProcessDeferredUpdateVehicleViewportHashes()
 
 void ResetVehicleHash()
 {
-	for (Vehicle *v : Vehicle::Iterate()) { v->hash_tile_current = nullptr; }
+	for (Vehicle *v : Vehicle::Iterate()) { v->hash_tile_current = INVALID_TILE; }
 	memset(_vehicle_viewport_hash, 0, sizeof(_vehicle_viewport_hash));
-	memset(_vehicle_tile_hash, 0, sizeof(_vehicle_tile_hash));
+	_vehicle_tile_hash.Reset();
+}
+
+/**
+ * Resize the vehicle tile hash to fit the number of vehicles in it.
+ * This must not be called while a vehicle tile hash chain is being iterated.
+ */
+void CheckVehicleTileHashSize()
+{
+	_vehicle_tile_hash.CheckSize();
 }
 
 void ResetVehicleColourMap()
@@ -1463,6 +1561,9 @@ void CallVehicleTicks()
 	_vehicles_to_pay_repair.clear();
 	_vehicles_to_sell.clear();
 
+	/* No vehicle chain is being iterated here, so this is a safe point to resize the tile hash */
+	CheckVehicleTileHashSize();
+
 	if (_tick_skip_counter == 0) RunVehicleDayProc();
 
 	if (_settings_game.economy.day_length_factor >= 8 && _game_mode == GM_NORMAL) {
@@ -1547,6 +1648,7 @@ void CallVehicleTicks()
 	}
 	{
 		PerformanceMeasurer framerate(PFE_GL_ROADVEHS);
+		if (_settings_client.gui.parallel_vehicle_pathfinding) PrefetchRoadVehiclePaths(_tick_road_veh_front_cache);
 		for (RoadVehicle *front : _tick_road_veh_front_cache) {
 			v = front;
 			if (!front->RoadVehicle::Tick()) continue;
@@ -1556,6 +1658,7 @@ void CallVehicleTicks()
 			}
 			if (!(front->vehstatus & VS_STOPPED)) VehicleTickMotion(front, front);
 		}
+		YapfRoadVehicleDiscardPrefetchedPaths();
 	}
 	{
 		PerformanceMeasurer framerate(PFE_GL_AIRCRAFT);
@@ -1570,6 +1673,7 @@ void CallVehicleTicks()
 	}
 	{
 		PerformanceMeasurer framerate(PFE_GL_SHIPS);
+		if (_settings_client.gui.parallel_vehicle_pathfinding) PrefetchShipPaths(_tick_ship_cache);
 		for (Ship *s : _tick_ship_cache) {
 			v = s;
 			if (!s->Ship::Tick()) continue;
@@ -1578,6 +1682,7 @@ void CallVehicleTicks()
 			}
 			if (!(s->vehstatus & VS_STOPPED)) VehicleTickMotion(s, s);
 		}
+		YapfShipDiscardPrefetchedPaths();
 	}
 	{
 		for (Vehicle *u : _tick_other_veh_cache) {
@@ -4575,6 +4680,95 @@ void DumpVehicleStats(char *buffer, const char *last)
 	buffer += seprintf(buffer, last, "  %10s: %5u\n", "total", (uint)Vehicle::GetNumItems());
 }
 
+/**
+ * Dump vehicle tile hash statistics and benchmark the position queries used by train collision checks
+ * and EnsureNoVehicleOnGround against the vehicles of the current game.
+ * @param b buffer
+ * @param last last byte of buffer
+ * @param iterations number of times to repeat each set of queries
+ * @return updated buffer
+ */
+char *BenchmarkVehicleTileHash(char *b, const char *last, uint iterations)
+{
+	static const char * const type_names[VEH_COMPANY_END] = { "train", "road", "ship", "aircraft" };
+
+	const uint buckets = 1 << _vehicle_tile_hash.bits;
+	b += seprintf(b, last, "Buckets: %u, vehicles: %u\n", buckets, _vehicle_tile_hash.count);
+	for (uint type = 0; type < VEH_COMPANY_END; type++) {
+		uint vehicles = 0;
+		uint max_tile = 0;
+		uint64 chain_sum = 0;
+		std::map<TileIndex, uint> tiles;
+		for (const Vehicle *v : Vehicle::Iterate()) {
+			if (v->type != type || v->hash_tile_current == INVALID_TILE) continue;
+			vehicles++;
+			max_tile = std::max(max_tile, ++tiles[v->hash_tile_current]);
+			/* Length of the chain which a query for the tile of this vehicle walks */
+			for (const Vehicle *u = _vehicle_tile_hash.buckets[_vehicle_tile_hash.Index(v->hash_tile_current, v->type)]; u != nullptr; u = u->hash_tile_next) chain_sum++;
+		}
+		if (vehicles == 0) continue;
+		b += seprintf(b, last, "  %-8s: %7u vehicles, %7u occupied tiles, %u max per tile, %.2f mean chain walked\n",
+				type_names[type], vehicles, (uint)tiles.size(), max_tile, (double)chain_sum / vehicles);
+	}
+
+	iterations = std::max<uint>(iterations, 1);
+
+	auto elapsed_ns = [](std::chrono::steady_clock::time_point start) -> uint64 {
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+	};
+	auto print_result = [&](const char *name, uint64 ns, uint64 queries, uint64 found) {
+		b += seprintf(b, last, "%-24s " OTTD_PRINTF64U " queries, %.3f ms, %.1f ns/query, " OTTD_PRINTF64U " found\n",
+				name, queries, ns / 1000000.0, queries > 0 ? (double)ns / queries : 0.0, found);
+	};
+
+	/* Same position test as FindTrainCollideEnum, without the collision side effects */
+	struct CollideQuery {
+		const Vehicle *v;
+		uint found;
+	};
+	auto collide_proc = [](Vehicle *v, void *data) -> Vehicle * {
+		CollideQuery *q = (CollideQuery *)data;
+		if (v == q->v || v->First() == q->v->First()) return nullptr;
+		int x_diff = v->x_pos - q->v->x_pos;
+		int y_diff = v->y_pos - q->v->y_pos;
+		if (abs(x_diff) < 6 && abs(y_diff) < 6) q->found++;
+		return nullptr;
+	};
+
+	uint64 queries = 0;
+	uint64 found = 0;
+	auto start = std::chrono::steady_clock::now();
+	for (uint i = 0; i < iterations; i++) {
+		for (const Train *t : Train::Iterate()) {
+			if (t->IsVirtual() || t->track == TRACK_BIT_DEPOT || (t->track & TRACK_BIT_WORMHOLE)) continue;
+			CollideQuery q{ t, 0 };
+			FindVehicleOnPosXY(t->x_pos, t->y_pos, VEH_TRAIN, &q, collide_proc);
+			queries++;
+			found += q.found;
+		}
+	}
+	print_result("Train collision (XY):", elapsed_ns(start), queries, found);
+
+	queries = 0;
+	found = 0;
+	start = std::chrono::steady_clock::now();
+	for (uint i = 0; i < iterations; i++) {
+		for (const Vehicle *v : Vehicle::Iterate()) {
+			if (v->type >= VEH_COMPANY_END || v->hash_tile_current == INVALID_TILE) continue;
+			/* Query the neighbouring tile, as EnsureNoVehicleOnGround would for adjacent construction */
+			TileIndex tile = TileAddWrap(v->tile, 1, 0);
+			if (tile == INVALID_TILE) continue;
+			for (uint type = 0; type < VEH_COMPANY_END; type++) {
+				if (HasVehicleOnPos(tile, (VehicleType)type, nullptr, &EnsureNoVehicleProc)) found++;
+				queries++;
+			}
+		}
+	}
+	print_result("Any vehicle on tile:", elapsed_ns(start), queries, found);
+
+	return b;
+}
+
 void AdjustVehicleScaledTickBase(int64 delta)
 {
 	for (Vehicle *v : Vehicle::Iterate()) {
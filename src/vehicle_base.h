@@ -308,7 +308,7 @@ public:
 
 	Vehicle *hash_tile_next;            ///< NOSAVE: Next vehicle in the tile location hash.
 	Vehicle **hash_tile_prev;           ///< NOSAVE: Previous vehicle in the tile location hash.
-	Vehicle **hash_tile_current;        ///< NOSAVE: Cache of the current hash chain.
+	TileIndex hash_tile_current;        ///< NOSAVE: Tile under which the vehicle is in the tile location hash, INVALID_TILE if it is not.
 
 	byte breakdown_severity;            ///< severity of the breakdown. Note that lower means more severe
 	byte breakdown_type;                ///< Type of breakdown
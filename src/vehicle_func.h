@@ -124,6 +124,7 @@ uint8 CalcPercentVehicleFilledOfCargo(const Vehicle *v, CargoID cargo);
 void VehicleLengthChanged(const Vehicle *u);
 
 void ResetVehicleHash();
+void CheckVehicleTileHashSize();
 void ResetVehicleColourMap();
 
 byte GetBestFittingSubType(Vehicle *v_from, Vehicle *v_for, CargoID dest_cargo_type);
@@ -13,6 +13,8 @@
 #include "../sl/saveload.h"
 #include "../window_func.h"
 #include "../thread.h"
+#include "../benchmark.h"
+#include "../openttd.h"
 #include "null_v.h"
 
 #include <atomic>
@@ -35,6 +37,11 @@ const char *VideoDriver_Null::Start(const StringList &parm)
 
 	this->ticks = GetDriverParamInt(parm, "ticks", 1000);
 	this->until_exit = GetDriverParamBool(parm, "until_exit");
+	const char *benchmark = GetDriverParam(parm, "benchmark");
+	this->benchmark_report = (benchmark != nullptr && *benchmark != '\0') ? benchmark : "";
+	const char *baseline = GetDriverParam(parm, "baseline");
+	this->benchmark_baseline = baseline != nullptr ? baseline : "";
+	this->benchmark_threshold = GetDriverParamInt(parm, "threshold", 10);
 	_screen.width  = _screen.pitch = _cur_resolution.width;
 	_screen.height = _cur_resolution.height;
 	_screen.dst_ptr = nullptr;
@@ -50,10 +57,38 @@ void VideoDriver_Null::Stop() { }
 
 void VideoDriver_Null::MakeDirty(int left, int top, int width, int height) {}
 
+/**
+ * Run the loaded savegame for the requested number of ticks, and write the benchmark report.
+ * The game is stopped with an error when the run regressed relative to the baseline.
+ */
+void VideoDriver_Null::RunBenchmark()
+{
+	/* Load the savegame before starting to measure. */
+	::GameLoop();
+	::InputLoop();
+	::UpdateWindows();
+	if (_game_mode != GM_NORMAL) usererror("Benchmark mode needs a savegame or scenario to load, use -g");
+
+	BeginBenchmark();
+	for (int i = 0; i < this->ticks; i++) {
+		::GameLoop();
+		::InputLoop();
+		::UpdateWindows();
+	}
+
+	BenchmarkOptions options;
+	options.report = this->benchmark_report.c_str();
+	if (!this->benchmark_baseline.empty()) options.baseline = this->benchmark_baseline.c_str();
+	options.threshold = this->benchmark_threshold;
+	if (!EndBenchmark(options, this->ticks)) usererror("Benchmark regressed relative to the baseline '%s'", options.baseline);
+}
+
 void VideoDriver_Null::MainLoop()
 {
 	SetSelfAsGameThread();
-	if (this->until_exit) {
+	if (!this->benchmark_report.empty()) {
+		this->RunBenchmark();
+	} else if (this->until_exit) {
 		while (!_exit_game) {
 			::GameLoop();
 			::InputLoop();
@@ -17,6 +17,11 @@ class VideoDriver_Null : public VideoDriver {
 private:
 	int ticks; ///< Amount of ticks to run.
 	bool until_exit;
+	std::string benchmark_report;   ///< File to write the benchmark report to, empty when not benchmarking.
+	std::string benchmark_baseline; ///< Benchmark report to compare against, if any.
+	uint benchmark_threshold;       ///< Allowed slowdown relative to the baseline, in percent.
+
+	void RunBenchmark();
 
 public:
 	const char *Start(const StringList &param) override;
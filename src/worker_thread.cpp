@@ -15,23 +15,37 @@
 
 WorkerThreadPool _general_worker_pool;
 
-void WorkerThreadPool::Start(const char *thread_name, uint max_workers)
+static thread_local const WorkerThreadPool *_current_worker_pool = nullptr; ///< Pool which the current thread is a worker of, if any.
+static thread_local uint _current_worker_index = 0;                         ///< Index of the current thread in _current_worker_pool.
+
+/**
+ * Start the worker threads of the pool, if not already started.
+ * @param thread_name Name of the worker threads.
+ * @param max_workers Maximum number of worker threads, the number of CPUs is used if lower.
+ * @param min_workers Minimum number of worker threads, even on single CPU systems.
+ */
+void WorkerThreadPool::Start(const char *thread_name, uint max_workers, uint min_workers)
 {
 	uint cpus = std::thread::hardware_concurrency();
-	if (cpus <= 1) return;
+	if (cpus <= 1 && min_workers == 0) return;
 
 	std::lock_guard<std::mutex> lk(this->lock);
 
 	this->exit = false;
 
-	uint worker_target = std::min<uint>(max_workers, cpus);
-	if (this->workers >= worker_target) return;
+	/* The set of worker queues is fixed while any worker is running. */
+	if (this->workers > 0) return;
 
-	uint new_workers = worker_target - this->workers;
+	uint worker_target = std::max<uint>(cpus <= 1 ? 0 : std::min<uint>(max_workers, cpus), min_workers);
+
+	this->queues.clear();
+	for (uint i = 0; i < worker_target; i++) {
+		this->queues.emplace_back(new WorkerQueue());
+	}
 
-	for (uint i = 0; i < new_workers; i++) {
+	for (uint i = 0; i < worker_target; i++) {
 		this->workers++;
-		if (!StartNewThread(nullptr, thread_name, &WorkerThreadPool::Run, this)) {
+		if (!StartNewThread(nullptr, thread_name, &WorkerThreadPool::Run, this, (uint)i)) {
 			this->workers--;
 			return;
 		}
@@ -48,37 +62,204 @@ void WorkerThreadPool::Stop()
 
 void WorkerThreadPool::EnqueueJob(WorkerJobFunc *func, void *data1, void *data2, void *data3)
 {
+	this->Submit([func, data1, data2, data3]() {
+		func(data1, data2, data3);
+	});
+}
+
+void WorkerThreadPool::Enqueue(Task &&task, TaskGroup *group, WorkerTaskPriority priority)
+{
+	if (group != nullptr) group->pending.fetch_add(1, std::memory_order_relaxed);
+
 	std::unique_lock<std::mutex> lk(this->lock);
 	if (this->workers == 0) {
 		/* Just execute it here and now */
 		lk.unlock();
-		func(data1, data2, data3);
+		QueuedTask qt{ std::move(task), group };
+		ExecuteTask(qt);
 		return;
 	}
-	bool notify = this->jobs.size() < (size_t)this->workers_waiting;
-	this->jobs.push({ func, data1, data2, data3 });
+
+	if (priority == WTP_NORMAL && _current_worker_pool == this) {
+		/* Submitted from one of our own workers, keep it local to that worker. */
+		lk.unlock();
+		WorkerQueue &queue = *this->queues[_current_worker_index];
+		{
+			std::lock_guard<std::mutex> queue_lk(queue.lock);
+			queue.tasks.push_back({ std::move(task), group });
+		}
+		lk.lock();
+	} else if (priority == WTP_HIGH) {
+		this->high_priority_tasks.push_back({ std::move(task), group });
+	} else {
+		this->shared_tasks.push_back({ std::move(task), group });
+	}
+	this->queued_tasks.fetch_add(1, std::memory_order_release);
+	bool notify = this->workers_waiting > 0;
 	lk.unlock();
 	if (notify) this->worker_wait_cv.notify_one();
 }
 
-void WorkerThreadPool::Run(WorkerThreadPool *pool)
+/**
+ * Try to take a task to run, in order: high priority tasks, own queue (newest first),
+ * shared queue (oldest first), other workers' queues (oldest first).
+ * @param worker_index Index of the calling worker, or -1 if not called from a worker.
+ * @param out Set to the task, if any.
+ * @return True if a task was taken.
+ */
+bool WorkerThreadPool::TryPopTask(int worker_index, QueuedTask &out)
 {
+	if (this->queued_tasks.load(std::memory_order_acquire) == 0) return false;
+
+	{
+		std::lock_guard<std::mutex> lk(this->lock);
+		if (!this->high_priority_tasks.empty()) {
+			out = std::move(this->high_priority_tasks.front());
+			this->high_priority_tasks.pop_front();
+			this->queued_tasks.fetch_sub(1, std::memory_order_relaxed);
+			return true;
+		}
+	}
+
+	if (worker_index >= 0) {
+		WorkerQueue &queue = *this->queues[worker_index];
+		std::lock_guard<std::mutex> lk(queue.lock);
+		if (!queue.tasks.empty()) {
+			out = std::move(queue.tasks.back());
+			queue.tasks.pop_back();
+			this->queued_tasks.fetch_sub(1, std::memory_order_relaxed);
+			return true;
+		}
+	}
+
+	{
+		std::lock_guard<std::mutex> lk(this->lock);
+		if (!this->shared_tasks.empty()) {
+			out = std::move(this->shared_tasks.front());
+			this->shared_tasks.pop_front();
+			this->queued_tasks.fetch_sub(1, std::memory_order_relaxed);
+			return true;
+		}
+	}
+
+	const uint count = (uint)this->queues.size();
+	for (uint i = 1; i <= count; i++) {
+		const uint victim = (std::max(worker_index, 0) + i) % count;
+		if ((int)victim == worker_index) continue;
+		WorkerQueue &queue = *this->queues[victim];
+		std::lock_guard<std::mutex> lk(queue.lock);
+		if (!queue.tasks.empty()) {
+			out = std::move(queue.tasks.front());
+			queue.tasks.pop_front();
+			this->queued_tasks.fetch_sub(1, std::memory_order_relaxed);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/**
+ * Try to take a not yet started task belonging to the given group.
+ * @param group Task group.
+ * @param out Set to the task, if any.
+ * @return True if a task was taken.
+ */
+bool WorkerThreadPool::TryPopGroupTask(const TaskGroup *group, QueuedTask &out)
+{
+	if (this->queued_tasks.load(std::memory_order_acquire) == 0) return false;
+
+	auto try_take = [&](std::deque<QueuedTask> &tasks) -> bool {
+		for (auto it = tasks.begin(); it != tasks.end(); ++it) {
+			if (it->group == group) {
+				out = std::move(*it);
+				tasks.erase(it);
+				this->queued_tasks.fetch_sub(1, std::memory_order_relaxed);
+				return true;
+			}
+		}
+		return false;
+	};
+
+	{
+		std::lock_guard<std::mutex> lk(this->lock);
+		if (try_take(this->high_priority_tasks) || try_take(this->shared_tasks)) return true;
+	}
+	for (auto &queue : this->queues) {
+		std::lock_guard<std::mutex> lk(queue->lock);
+		if (try_take(queue->tasks)) return true;
+	}
+	return false;
+}
+
+/* static */ void WorkerThreadPool::ExecuteTask(QueuedTask &task)
+{
+	task.task();
+	task.task = nullptr;
+	if (task.group != nullptr) task.group->TaskDone();
+}
+
+void WorkerThreadPool::Run(WorkerThreadPool *pool, uint worker_index)
+{
+	_current_worker_pool = pool;
+	_current_worker_index = worker_index;
+
+	QueuedTask task;
 	std::unique_lock<std::mutex> lk(pool->lock);
-	while (!pool->exit || !pool->jobs.empty()) {
-		if (pool->jobs.empty()) {
-			pool->workers_waiting++;
-			pool->worker_wait_cv.wait(lk);
-			pool->workers_waiting--;
-		} else {
-			WorkerJob job = pool->jobs.front();
-			pool->jobs.pop();
-			lk.unlock();
-			job.func(job.data1, job.data2, job.data3);
+	while (true) {
+		lk.unlock();
+		if (pool->TryPopTask((int)worker_index, task)) {
+			ExecuteTask(task);
 			lk.lock();
+			continue;
 		}
+		lk.lock();
+		if (pool->queued_tasks.load(std::memory_order_acquire) != 0) continue;
+		if (pool->exit) break;
+		pool->workers_waiting++;
+		pool->worker_wait_cv.wait(lk);
+		pool->workers_waiting--;
 	}
 	pool->workers--;
 	if (pool->workers == 0) {
 		pool->done_cv.notify_all();
 	}
+
+	_current_worker_pool = nullptr;
+}
+
+void WorkerThreadPool::TaskGroup::TaskDone()
+{
+	/* The decrement is done with the lock held, such that a waiting thread cannot observe the group as done
+	 * and destroy it before this function has finished with it. */
+	std::lock_guard<std::mutex> lk(this->lock);
+	if (this->pending.fetch_sub(1, std::memory_order_acq_rel) == 1) this->done_cv.notify_all();
+}
+
+/**
+ * Wait for all tasks of the group to complete.
+ * Tasks of the group which have not yet been started are run on the calling thread, other tasks are not.
+ */
+void WorkerThreadPool::TaskGroup::Wait()
+{
+	QueuedTask task;
+	while (true) {
+		if (this->pool.TryPopGroupTask(this, task)) {
+			ExecuteTask(task);
+			continue;
+		}
+		std::unique_lock<std::mutex> lk(this->lock);
+		if (this->pending.load(std::memory_order_acquire) == 0) return;
+		this->done_cv.wait(lk);
+	}
+}
+
+/**
+ * Wait for all tasks of the group to complete.
+ * Unlike Wait, tasks of the group which have not yet been started are left to the workers, and are never run on the calling thread.
+ */
+void WorkerThreadPool::TaskGroup::WaitForCompletion()
+{
+	std::unique_lock<std::mutex> lk(this->lock);
+	this->done_cv.wait(lk, [this]() { return this->pending.load(std::memory_order_acquire) == 0; });
 }
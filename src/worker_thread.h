@@ -10,9 +10,14 @@
 #ifndef WORKER_THREAD_H
 #define WORKER_THREAD_H
 
-#include <queue>
+#include "core/math_func.hpp"
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
 #include <mutex>
 #include <condition_variable>
+#include <vector>
 #if defined(__MINGW32__)
 #include "3rdparty/mingw-std-threads/mingw.mutex.h"
 #include "3rdparty/mingw-std-threads/mingw.condition_variable.h"
@@ -20,31 +25,159 @@
 
 typedef void WorkerJobFunc(void *, void *, void *);
 
+/** Priority of a worker thread pool task. */
+enum WorkerTaskPriority : uint8 {
+	WTP_NORMAL, ///< Normal priority.
+	WTP_HIGH,   ///< High priority, started before any normal priority task which has not yet been started.
+};
+
+/**
+ * Pool of worker threads.
+ *
+ * Each worker has its own task deque. Tasks submitted from a worker thread are pushed to the back of
+ * that worker's deque and are popped from the back (LIFO) by the same worker, other idle workers steal
+ * from the front. Tasks submitted from other threads and high priority tasks go to shared queues.
+ *
+ * If the pool has no workers (single CPU systems, or before Start/after Stop), tasks are run immediately
+ * on the submitting thread.
+ */
 struct WorkerThreadPool {
+	typedef std::function<void()> Task;
+
+	/**
+	 * Set of tasks which can be waited on together.
+	 * The group must not be destroyed before all its tasks have completed, the destructor waits for this.
+	 */
+	class TaskGroup {
+		friend WorkerThreadPool;
+
+		WorkerThreadPool &pool;
+		std::atomic<uint> pending = 0;     ///< Number of tasks in the group which have not yet completed.
+		std::mutex lock;
+		std::condition_variable done_cv;
+
+		void TaskDone();
+
+	public:
+		TaskGroup(WorkerThreadPool &pool) : pool(pool) {}
+		TaskGroup(const TaskGroup &) = delete;
+		TaskGroup &operator=(const TaskGroup &) = delete;
+
+		~TaskGroup()
+		{
+			this->Wait();
+		}
+
+		/**
+		 * Submit a task to the pool as part of this group.
+		 * @param task Task to run.
+		 * @param priority Task priority.
+		 */
+		void Run(Task task, WorkerTaskPriority priority = WTP_NORMAL)
+		{
+			this->pool.Enqueue(std::move(task), this, priority);
+		}
+
+		void Wait();
+		void WaitForCompletion();
+
+		/**
+		 * Check whether all tasks in the group have completed, without waiting.
+		 * @return True if no task of the group is queued or running.
+		 */
+		bool IsDone() const
+		{
+			return this->pending.load(std::memory_order_acquire) == 0;
+		}
+	};
+
 private:
-	struct WorkerJob {
-		WorkerJobFunc *func;
-		void *data1;
-		void *data2;
-		void *data3;
+	struct QueuedTask {
+		Task task;
+		TaskGroup *group;
+	};
+
+	struct WorkerQueue {
+		std::mutex lock;
+		std::deque<QueuedTask> tasks;
 	};
 
 	uint workers = 0;
 	uint workers_waiting = 0;
 	bool exit = false;
 	std::mutex lock;
-	std::queue<WorkerJob> jobs;
+	std::deque<QueuedTask> shared_tasks;                  ///< Normal priority tasks submitted from non-worker threads, protected by lock.
+	std::deque<QueuedTask> high_priority_tasks;           ///< High priority tasks, protected by lock.
+	std::vector<std::unique_ptr<WorkerQueue>> queues;     ///< Per-worker task queues.
+	std::atomic<uint> queued_tasks = 0;                   ///< Number of tasks in all queues.
 	std::condition_variable worker_wait_cv;
 	std::condition_variable done_cv;
 
-	static void Run(WorkerThreadPool *pool);
+	static void Run(WorkerThreadPool *pool, uint worker_index);
+
+	void Enqueue(Task &&task, TaskGroup *group, WorkerTaskPriority priority);
+	bool TryPopTask(int worker_index, QueuedTask &out);
+	bool TryPopGroupTask(const TaskGroup *group, QueuedTask &out);
+	static void ExecuteTask(QueuedTask &task);
 
 public:
 
-	void Start(const char *thread_name, uint max_workers);
+	void Start(const char *thread_name, uint max_workers, uint min_workers = 0);
 	void Stop();
 	void EnqueueJob(WorkerJobFunc *func, void *data1 = nullptr, void *data2 = nullptr, void *data3 = nullptr);
 
+	/**
+	 * Submit a task which is not part of any group.
+	 * @param task Task to run.
+	 * @param priority Task priority.
+	 */
+	void Submit(Task task, WorkerTaskPriority priority = WTP_NORMAL)
+	{
+		this->Enqueue(std::move(task), nullptr, priority);
+	}
+
+	/**
+	 * Run \a func over the index range [\a begin, \a end) split into chunks of at most \a grain indices,
+	 * and wait for all chunks to complete. The calling thread also processes chunks.
+	 * @param begin First index.
+	 * @param end One past the last index.
+	 * @param grain Maximum number of indices per chunk.
+	 * @param func Function called as func(chunk_begin, chunk_end) for each chunk, possibly concurrently.
+	 */
+	template <typename F>
+	void ParallelFor(size_t begin, size_t end, size_t grain, F func)
+	{
+		if (begin >= end) return;
+		grain = std::max<size_t>(grain, 1);
+		const size_t chunks = CeilDivT<size_t>(end - begin, grain);
+
+		std::atomic<size_t> next_chunk = 0;
+		auto process_chunks = [&]() {
+			for (size_t chunk = next_chunk.fetch_add(1, std::memory_order_relaxed); chunk < chunks; chunk = next_chunk.fetch_add(1, std::memory_order_relaxed)) {
+				const size_t chunk_begin = begin + (chunk * grain);
+				func(chunk_begin, std::min(end, chunk_begin + grain));
+			}
+		};
+
+		TaskGroup group(*this);
+		const size_t helpers = std::min<size_t>(chunks - 1, this->WorkerCount());
+		for (size_t i = 0; i < helpers; i++) {
+			group.Run(process_chunks);
+		}
+		process_chunks();
+		group.Wait();
+	}
+
+	/**
+	 * Get the number of worker threads.
+	 * @return Number of worker threads, 0 if tasks are run on the submitting thread.
+	 */
+	uint WorkerCount()
+	{
+		std::lock_guard<std::mutex> lk(this->lock);
+		return this->workers;
+	}
+
 	~WorkerThreadPool()
 	{
 		this->Stop();